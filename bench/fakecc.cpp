@@ -0,0 +1,187 @@
+// 基准测试使用的替身编译器：不编译代码，只生成 buildpp 需要的输出文件，
+// 使测得的时间主要是 buildpp 自身的开销
+//
+//   --version               输出固定的版本信息
+//   -E SRC -o OUT           把源文件及其包含的头文件的内容写入 OUT
+//   -c SRC -o OUT           写入目标文件（源文件内容的哈希），有 -MF 时写入依赖文件
+//   -x c++-header SRC -o OUT  同 -c（预编译头）
+//   其他                     视为链接：把所有输入文件名写入 OUT
+//
+// 依赖文件列出源文件中 #include "..." 递归包含的所有头文件（在源文件目录和 -I 目录中查找），
+// 与真实编译器的 -MMD 相同。设置环境变量 FAKECC_LOG 时每次调用在该文件末尾追加一行，用于统计进程启动次数
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <set>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+
+static bool readFile(const std::string& path, std::string& content) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    content = buffer.str();
+    return true;
+}
+
+static std::string directoryOf(const std::string& path) {
+    size_t slash = path.find_last_of('/');
+    return slash == std::string::npos ? "." : path.substr(0, slash);
+}
+
+// 递归收集 file 包含的头文件，content 为所有文件内容的拼接
+static void collectIncludes(const std::string& file, const std::vector<std::string>& includeDirs,
+                            std::set<std::string>& seen, std::vector<std::string>& headers,
+                            std::string& content) {
+    std::string text;
+    if (!readFile(file, text)) {
+        return;
+    }
+    content += text;
+    
+    std::istringstream lines(text);
+    std::string line;
+    while (std::getline(lines, line)) {
+        if (line.compare(0, 10, "#include \"") != 0) {
+            continue;
+        }
+        size_t end = line.find('"', 10);
+        if (end == std::string::npos) {
+            continue;
+        }
+        std::string name = line.substr(10, end - 10);
+        
+        std::vector<std::string> candidates = {directoryOf(file) + "/" + name};
+        for (const auto& dir : includeDirs) {
+            candidates.push_back(dir + "/" + name);
+        }
+        for (const auto& candidate : candidates) {
+            std::ifstream probe(candidate);
+            if (!probe.is_open()) {
+                continue;
+            }
+            if (seen.insert(candidate).second) {
+                headers.push_back(candidate);
+                collectIncludes(candidate, includeDirs, seen, headers, content);
+            }
+            break;
+        }
+    }
+}
+
+// 展开 @响应文件（buildpp 在命令行过长时使用）
+static void appendArgs(const std::string& arg, std::vector<std::string>& args) {
+    std::string content;
+    if (arg.size() > 1 && arg[0] == '@' && readFile(arg.substr(1), content)) {
+        std::istringstream words(content);
+        std::string word;
+        while (words >> word) {
+            if (word.size() >= 2 && word.front() == '"' && word.back() == '"') {
+                word = word.substr(1, word.size() - 2);
+            }
+            args.push_back(word);
+        }
+        return;
+    }
+    args.push_back(arg);
+}
+
+static uint64_t fnv1a(const std::string& data) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : data) {
+        hash = (hash ^ c) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; i++) {
+        appendArgs(argv[i], args);
+    }
+    
+    const char* log = std::getenv("FAKECC_LOG");
+    if (log && *log) {
+        std::ofstream out(log, std::ios::app);
+        out << (args.empty() ? "" : args[0]) << "\n";
+    }
+    
+    std::string output, depFile, depTarget, source;
+    std::vector<std::string> includeDirs, inputs;
+    bool compile = false, preprocess = false;
+    for (size_t i = 0; i < args.size(); i++) {
+        const std::string& arg = args[i];
+        if (arg == "--version") {
+            std::cout << "fakecc 1.0 (buildpp benchmark stand-in)" << std::endl;
+            return 0;
+        } else if (arg == "-c") {
+            compile = true;
+        } else if (arg == "-E") {
+            preprocess = true;
+        } else if (arg == "-x" && i + 1 < args.size()) {
+            compile = compile || args[++i] == "c++-header";
+        } else if ((arg == "-o" || arg == "-MF" || arg == "-MT" || arg == "-include" ||
+                    arg == "-include-pch") && i + 1 < args.size()) {
+            const std::string& value = args[++i];
+            if (arg == "-o") output = value;
+            if (arg == "-MF") depFile = value;
+            if (arg == "-MT") depTarget = value;
+        } else if (arg.compare(0, 2, "-I") == 0 && arg.size() > 2) {
+            includeDirs.push_back(arg.substr(2));
+        } else if (!arg.empty() && arg[0] != '-') {
+            inputs.push_back(arg);
+        }
+    }
+    if (output.empty()) {
+        std::cerr << "fakecc: missing -o" << std::endl;
+        return 1;
+    }
+    
+    // 链接：输出文件列出所有输入
+    if (!compile && !preprocess) {
+        std::ofstream out(output, std::ios::binary | std::ios::trunc);
+        for (const auto& input : inputs) {
+            out << input << "\n";
+        }
+        return out ? 0 : 1;
+    }
+    
+    if (inputs.empty()) {
+        std::cerr << "fakecc: missing source file" << std::endl;
+        return 1;
+    }
+    source = inputs.back();
+    std::set<std::string> seen;
+    std::vector<std::string> headers;
+    std::string content;
+    if (!readFile(source, content)) {
+        std::cerr << "fakecc: cannot read " << source << std::endl;
+        return 1;
+    }
+    content.clear();
+    collectIncludes(source, includeDirs, seen, headers, content);
+    
+    std::ofstream out(output, std::ios::binary | std::ios::trunc);
+    if (preprocess) {
+        out << content;
+    } else {
+        out << "FAKEOBJ " << std::hex << fnv1a(content) << "\n";
+    }
+    out.close();
+    
+    if (!depFile.empty()) {
+        std::ofstream dep(depFile, std::ios::trunc);
+        dep << (depTarget.empty() ? output : depTarget) << ": " << source;
+        for (const auto& header : headers) {
+            dep << " \\\n  " << header;
+        }
+        dep << "\n";
+    }
+    return out ? 0 : 1;
+}
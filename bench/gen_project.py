@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+# 生成用于测量 buildpp 自身开销的合成项目
+#
+# 源文件按 --depth 层目录分布在 src/ 下（每层 --branch 个子目录），头文件放在 include/ 中。
+# 每个源文件随机包含 --fanout 个头文件，每个头文件再随机包含 --header-includes 个编号更大的头文件
+# （不会形成循环），编号越大的头文件被越多的源文件间接包含
+#
+# 用法: gen_project.py OUT_DIR --sources 1000 --headers 200 --fanout 10 --depth 3 --compiler /path/to/fakecc
+
+import argparse
+import json
+import os
+import random
+import shutil
+
+
+def source_dir(index, depth, branch):
+    # 按编号确定源文件所在的目录，如 src/d1/d3/d0
+    parts = []
+    value = index
+    for _ in range(depth):
+        parts.append("d%d" % (value % branch))
+        value //= branch
+    return os.path.join("src", *parts)
+
+
+def generate(args):
+    # 只覆盖空目录或之前生成的项目，避免误删其他文件
+    if os.path.exists(args.out_dir) and os.listdir(args.out_dir):
+        if not args.force:
+            raise SystemExit("Error: %s is not empty (use --force to replace it)" % args.out_dir)
+        shutil.rmtree(args.out_dir)
+    rng = random.Random(args.seed)
+    os.makedirs(os.path.join(args.out_dir, "include"))
+
+    for h in range(args.headers):
+        later = list(range(h + 1, args.headers))
+        includes = sorted(rng.sample(later, min(args.header_includes, len(later))))
+        with open(os.path.join(args.out_dir, "include", "h%d.hpp" % h), "w") as f:
+            f.write("#pragma once\n")
+            for i in includes:
+                f.write('#include "h%d.hpp"\n' % i)
+            f.write("int h%d_value();\n" % h)
+
+    for s in range(args.sources):
+        directory = os.path.join(args.out_dir, source_dir(s, args.depth, args.branch))
+        os.makedirs(directory, exist_ok=True)
+        includes = sorted(rng.sample(range(args.headers), min(args.fanout, args.headers)))
+        with open(os.path.join(directory, "s%d.cpp" % s), "w") as f:
+            for i in includes:
+                f.write('#include "h%d.hpp"\n' % i)
+            f.write("int s%d_value() { return %d; }\n" % (s, s))
+            if s == 0:
+                f.write("int main() { return 0; }\n")
+
+    config = {
+        "project_name": "bench",
+        "source_files": ["src/**/*.cpp"],
+        "include_dirs": ["include"],
+        "compiler": args.compiler,
+        "linker": "default",
+        "jobs": args.jobs,
+    }
+    with open(os.path.join(args.out_dir, "build.json"), "w") as f:
+        json.dump(config, f, indent=2)
+        f.write("\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate a synthetic project for benchmarking buildpp")
+    parser.add_argument("out_dir")
+    parser.add_argument("--sources", type=int, default=1000, help="number of source files")
+    parser.add_argument("--headers", type=int, default=200, help="number of headers")
+    parser.add_argument("--fanout", type=int, default=10, help="headers included directly by each source")
+    parser.add_argument("--header-includes", type=int, default=2, help="headers included by each header")
+    parser.add_argument("--depth", type=int, default=3, help="directory depth of sources under src/")
+    parser.add_argument("--branch", type=int, default=4, help="subdirectories per directory level")
+    parser.add_argument("--jobs", type=int, default=0, help="jobs in the generated build.json")
+    parser.add_argument("--compiler", default="g++", help="compiler in the generated build.json")
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--force", action="store_true", help="replace OUT_DIR if it is not empty")
+    args = parser.parse_args()
+    if args.headers < 1 or args.sources < 1:
+        parser.error("--sources and --headers must be at least 1")
+    generate(args)
+
+
+if __name__ == "__main__":
+    main()
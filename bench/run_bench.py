@@ -0,0 +1,181 @@
+#!/usr/bin/env python3
+# 测量 buildpp 自身的开销
+#
+# 编译替身编译器 fakecc，生成合成项目（见 gen_project.py），然后分别测量：
+#   clean         删除构建目录后完整构建
+#   null          没有任何修改的构建
+#   touch_header  修改一个被多个源文件包含的头文件的时间戳后构建
+#   touch_source  修改一个源文件的时间戳后构建
+# 每个场景重复 --repeat 次，结果以 JSON 输出：墙钟时间、buildpp 及其子进程的 CPU 时间、
+# 编译器进程启动次数，以及安装了 strace 时单独运行一次统计的系统调用次数
+#
+# 用法: run_bench.py --buildpp ./buildpp [--sources 2000] [--repeat 5] [--output result.json]
+
+import argparse
+import json
+import os
+import resource
+import shutil
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+import gen_project
+
+BENCH_DIR = os.path.dirname(os.path.abspath(__file__))
+SCENARIOS = ["clean", "null", "touch_header", "touch_source"]
+
+
+def build_fakecc(work_dir):
+    compiler = os.environ.get("CXX", "g++")
+    output = os.path.join(work_dir, "fakecc")
+    subprocess.run([compiler, "-std=c++17", "-O2", os.path.join(BENCH_DIR, "fakecc.cpp"), "-o", output],
+                   check=True)
+    return output
+
+
+def prepare(scenario, project_dir, args):
+    # 每次运行前把项目恢复到场景要求的状态
+    if scenario == "clean":
+        shutil.rmtree(os.path.join(project_dir, "build"), ignore_errors=True)
+    elif scenario == "touch_header":
+        os.utime(os.path.join(project_dir, "include", "h%d.hpp" % (args.headers // 2)))
+    elif scenario == "touch_source":
+        index = args.sources // 2
+        path = os.path.join(project_dir, gen_project.source_dir(index, args.depth, args.branch), "s%d.cpp" % index)
+        os.utime(path)
+
+
+def run_buildpp(command, project_dir, spawn_log):
+    # 返回墙钟时间、子进程 CPU 时间（毫秒）和编译器启动次数
+    open(spawn_log, "w").close()
+    env = dict(os.environ, FAKECC_LOG=spawn_log)
+    before = resource.getrusage(resource.RUSAGE_CHILDREN)
+    start = time.perf_counter()
+    result = subprocess.run(command, cwd=project_dir, env=env, stdout=subprocess.DEVNULL,
+                            stderr=subprocess.PIPE, universal_newlines=True)
+    wall = (time.perf_counter() - start) * 1000
+    after = resource.getrusage(resource.RUSAGE_CHILDREN)
+    if result.returncode != 0:
+        sys.stderr.write(result.stderr)
+        raise SystemExit("Error: buildpp failed in %s" % project_dir)
+    with open(spawn_log) as f:
+        spawns = sum(1 for _ in f)
+    return {
+        "wall_ms": wall,
+        "user_ms": (after.ru_utime - before.ru_utime) * 1000,
+        "sys_ms": (after.ru_stime - before.ru_stime) * 1000,
+        "spawns": spawns,
+    }
+
+
+def count_syscalls(command, project_dir, spawn_log):
+    # strace -c 的汇总表最后一行为 total，第 4 列是调用次数；-f 包括编译器等子进程
+    with tempfile.NamedTemporaryFile(suffix=".strace") as summary:
+        run_buildpp(["strace", "-f", "-c", "-o", summary.name] + command, project_dir, spawn_log)
+        calls = {}
+        for line in open(summary.name):
+            fields = line.split()
+            if len(fields) >= 5 and fields[3].isdigit():
+                calls[fields[-1]] = int(fields[3])
+        return calls
+
+
+def summarize(runs):
+    walls = [run["wall_ms"] for run in runs]
+    return {
+        "runs": len(runs),
+        "wall_ms": {
+            "min": round(min(walls), 2),
+            "median": round(statistics.median(walls), 2),
+            "max": round(max(walls), 2),
+        },
+        "user_ms": round(statistics.median(run["user_ms"] for run in runs), 2),
+        "sys_ms": round(statistics.median(run["sys_ms"] for run in runs), 2),
+        "spawns": runs[-1]["spawns"],
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Measure buildpp overhead on a synthetic project")
+    parser.add_argument("--buildpp", required=True, help="buildpp binary to measure")
+    parser.add_argument("--work-dir", help="directory for fakecc and the generated project (default: temporary)")
+    parser.add_argument("--sources", type=int, default=2000)
+    parser.add_argument("--headers", type=int, default=400)
+    parser.add_argument("--fanout", type=int, default=10)
+    parser.add_argument("--header-includes", type=int, default=2)
+    parser.add_argument("--depth", type=int, default=3)
+    parser.add_argument("--branch", type=int, default=4)
+    parser.add_argument("--jobs", type=int, default=0, help="-j passed to buildpp (0 = its default)")
+    parser.add_argument("--repeat", type=int, default=5, help="runs per scenario")
+    parser.add_argument("--scenarios", default=",".join(SCENARIOS), help="comma-separated scenarios to run")
+    parser.add_argument("--no-syscalls", action="store_true", help="do not count syscalls even if strace exists")
+    parser.add_argument("--output", help="write the JSON result to this file instead of stdout")
+    args = parser.parse_args()
+
+    scenarios = [name for name in args.scenarios.split(",") if name]
+    for name in scenarios:
+        if name not in SCENARIOS:
+            parser.error("unknown scenario: %s" % name)
+
+    work_dir = args.work_dir or tempfile.mkdtemp(prefix="buildpp-bench-")
+    os.makedirs(work_dir, exist_ok=True)
+    buildpp = os.path.abspath(args.buildpp)
+    project_dir = os.path.join(work_dir, "project")
+    spawn_log = os.path.join(work_dir, "spawns.log")
+
+    generate_args = argparse.Namespace(
+        out_dir=project_dir, sources=args.sources, headers=args.headers, fanout=args.fanout,
+        header_includes=args.header_includes, depth=args.depth, branch=args.branch, jobs=0,
+        compiler=build_fakecc(work_dir), seed=1, force=True)
+    gen_project.generate(generate_args)
+
+    command = [buildpp, "build"]
+    if args.jobs > 0:
+        command = [buildpp, "-j", str(args.jobs), "build"]
+    use_strace = not args.no_syscalls and shutil.which("strace") is not None
+
+    # 先完整构建一次，null 和 touch 场景从已构建的状态开始
+    run_buildpp(command, project_dir, spawn_log)
+    results = {}
+    for name in scenarios:
+        runs = []
+        for _ in range(args.repeat):
+            prepare(name, project_dir, generate_args)
+            runs.append(run_buildpp(command, project_dir, spawn_log))
+        results[name] = summarize(runs)
+        if use_strace:
+            prepare(name, project_dir, generate_args)
+            calls = count_syscalls(command, project_dir, spawn_log)
+            results[name]["syscalls"] = calls.get("total")
+            results[name]["syscalls_by_name"] = {
+                key: value for key, value in sorted(calls.items(), key=lambda item: -item[1])[:10]
+                if key != "total"
+            }
+        else:
+            results[name]["syscalls"] = None
+
+    report = {
+        "buildpp": buildpp,
+        "project": {
+            "sources": args.sources, "headers": args.headers, "fanout": args.fanout,
+            "header_includes": args.header_includes, "depth": args.depth, "branch": args.branch,
+        },
+        "jobs": args.jobs,
+        "repeat": args.repeat,
+        "scenarios": results,
+    }
+    text = json.dumps(report, indent=2) + "\n"
+    if args.output:
+        with open(args.output, "w") as f:
+            f.write(text)
+    else:
+        sys.stdout.write(text)
+    if not args.work_dir:
+        shutil.rmtree(work_dir, ignore_errors=True)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,251 @@
+#include "buildlog.hpp"
+#include "hash.hpp"
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// 文件格式：16字节文件头 + 按 key 排序的定长记录
+struct BuildLogHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t count;
+};
+
+static const char BUILD_LOG_MAGIC[4] = {'B', 'P', 'B', 'L'};
+static const uint32_t BUILD_LOG_VERSION = 3;
+
+// 旧版本的记录：版本 1 没有耗时，版本 2 没有峰值内存，加载时转换为当前格式
+struct BuildLogEntryV1 {
+    uint64_t key;
+    uint64_t commandHash;
+    uint64_t inputHash;
+};
+
+struct BuildLogEntryV2 {
+    uint64_t key;
+    uint64_t commandHash;
+    uint64_t inputHash;
+    uint64_t durationMs;
+};
+
+static BuildLogEntry upgradeEntry(const BuildLogEntryV1& old) {
+    return {old.key, old.commandHash, old.inputHash, 0, 0};
+}
+
+static BuildLogEntry upgradeEntry(const BuildLogEntryV2& old) {
+    return {old.key, old.commandHash, old.inputHash, old.durationMs, 0};
+}
+
+// 文件中是旧版本 OldEntry 格式的记录时逐条转换到 buffer，否则返回 false
+template <typename OldEntry>
+static bool upgradeEntries(const char* data, size_t size, const BuildLogHeader& header, uint32_t version,
+                           std::vector<BuildLogEntry>& buffer) {
+    if (header.version != version || header.count != (size - sizeof(header)) / sizeof(OldEntry)) {
+        return false;
+    }
+    buffer.resize(static_cast<size_t>(header.count));
+    for (size_t i = 0; i < buffer.size(); i++) {
+        OldEntry old;
+        memcpy(&old, data + sizeof(header) + i * sizeof(old), sizeof(old));
+        buffer[i] = upgradeEntry(old);
+    }
+    return true;
+}
+
+BuildLog::BuildLog() : entries(nullptr), entryCount(0), mapping(nullptr), mappingSize(0) {
+}
+
+BuildLog::~BuildLog() {
+    unload();
+}
+
+void BuildLog::unload() {
+#ifndef _WIN32
+    if (mapping) {
+        munmap(mapping, mappingSize);
+    }
+#endif
+    mapping = nullptr;
+    mappingSize = 0;
+    entries = nullptr;
+    entryCount = 0;
+    buffer.clear();
+}
+
+bool BuildLog::load(const std::string& logFile) {
+    std::lock_guard<std::mutex> lock(mutex);
+    unload();
+    updates.clear();
+    filename = logFile;
+    
+    const char* data = nullptr;
+    size_t size = 0;
+    
+#ifdef _WIN32
+    std::ifstream in(filename, std::ios::binary);
+    if (!in.is_open()) {
+        return true;
+    }
+    std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (content.size() >= sizeof(BuildLogHeader)) {
+        buffer.resize((content.size() - sizeof(BuildLogHeader)) / sizeof(BuildLogEntry));
+        memcpy(buffer.data(), content.data() + sizeof(BuildLogHeader), buffer.size() * sizeof(BuildLogEntry));
+    }
+    data = content.data();
+    size = content.size();
+#else
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return true;
+    }
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size >= static_cast<off_t>(sizeof(BuildLogHeader))) {
+        size = static_cast<size_t>(info.st_size);
+        void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED) {
+            mapping = mapped;
+            mappingSize = size;
+            data = static_cast<const char*>(mapped);
+        }
+    }
+    close(fd);
+#endif
+    
+    if (!data || size < sizeof(BuildLogHeader)) {
+        return true;
+    }
+    
+    BuildLogHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, BUILD_LOG_MAGIC, 4) == 0 &&
+        (upgradeEntries<BuildLogEntryV1>(data, size, header, 1, buffer) ||
+         upgradeEntries<BuildLogEntryV2>(data, size, header, 2, buffer))) {
+        entries = buffer.data();
+        entryCount = buffer.size();
+        return true;
+    }
+    if (memcmp(header.magic, BUILD_LOG_MAGIC, 4) != 0 || header.version != BUILD_LOG_VERSION ||
+        header.count != (size - sizeof(header)) / sizeof(BuildLogEntry)) {
+        // 格式不符的日志直接丢弃，相当于所有目标都需要重新构建
+        std::cerr << "Warning: Ignoring invalid build log: " << filename << std::endl;
+        unload();
+        return false;
+    }
+    
+#ifdef _WIN32
+    entries = buffer.data();
+#else
+    entries = reinterpret_cast<const BuildLogEntry*>(data + sizeof(header));
+#endif
+    entryCount = static_cast<size_t>(header.count);
+    return true;
+}
+
+bool BuildLog::find(const std::string& output, BuildLogEntry& entry) const {
+    uint64_t key = hashString(output);
+    std::lock_guard<std::mutex> lock(mutex);
+    
+    auto it = updates.find(key);
+    if (it != updates.end()) {
+        entry = it->second;
+        return true;
+    }
+    
+    const BuildLogEntry* end = entries + entryCount;
+    const BuildLogEntry* found = std::lower_bound(entries, end, key,
+        [](const BuildLogEntry& e, uint64_t k) { return e.key < k; });
+    if (found != end && found->key == key) {
+        entry = *found;
+        return true;
+    }
+    return false;
+}
+
+void BuildLog::record(const std::string& output, uint64_t commandHash, uint64_t inputHash,
+                      uint64_t durationMs, uint64_t peakMemoryKb) {
+    BuildLogEntry entry;
+    entry.key = hashString(output);
+    entry.commandHash = commandHash;
+    entry.inputHash = inputHash;
+    entry.durationMs = durationMs;
+    entry.peakMemoryKb = peakMemoryKb;
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    updates[entry.key] = entry;
+}
+
+bool BuildLog::save() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (updates.empty() || filename.empty()) {
+        return true;
+    }
+    
+    // 合并已有记录与本次更新，两者都按 key 有序
+    std::vector<BuildLogEntry> merged;
+    merged.reserve(entryCount + updates.size());
+    size_t i = 0;
+    auto it = updates.begin();
+    while (i < entryCount || it != updates.end()) {
+        if (it == updates.end() || (i < entryCount && entries[i].key < it->first)) {
+            merged.push_back(entries[i++]);
+        } else {
+            if (i < entryCount && entries[i].key == it->first) {
+                i++;
+            }
+            merged.push_back(it->second);
+            ++it;
+        }
+    }
+    
+    BuildLogHeader header;
+    memcpy(header.magic, BUILD_LOG_MAGIC, 4);
+    header.version = BUILD_LOG_VERSION;
+    header.count = merged.size();
+    
+    std::string tempFile = filename + ".tmp";
+    std::ofstream out(tempFile, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "Warning: Cannot write build log: " << tempFile << std::endl;
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(merged.data()), merged.size() * sizeof(BuildLogEntry));
+    out.close();
+    
+    // 写入不完整（如磁盘已满）时保留原来的日志
+    if (!out.good()) {
+        std::remove(tempFile.c_str());
+        std::cerr << "Warning: Cannot write build log: " << tempFile << std::endl;
+        return false;
+    }
+    
+#ifdef _WIN32
+    std::remove(filename.c_str());
+#endif
+    // 先重命名再释放映射：映射的是原来的文件，重命名后仍然有效
+    bool renamed = std::rename(tempFile.c_str(), filename.c_str()) == 0;
+    if (!renamed) {
+        std::remove(tempFile.c_str());
+        std::cerr << "Warning: Cannot write build log: " << filename << std::endl;
+    }
+    
+    // 之后以内存中的合并结果继续提供查询（常驻的 watch 模式不会因此丢失记录）；
+    // 保存失败时保留本次的更新，下次保存时再写入
+    unload();
+    buffer.swap(merged);
+    entries = buffer.data();
+    entryCount = buffer.size();
+    if (renamed) {
+        updates.clear();
+    }
+    return renamed;
+}
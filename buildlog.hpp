@@ -0,0 +1,53 @@
+#ifndef BUILDLOG_HPP
+#define BUILDLOG_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <cstdint>
+
+// 构建日志中的一条记录（定长，可直接从映射的文件中读取）
+struct BuildLogEntry {
+    uint64_t key;         // 输出文件路径的哈希
+    uint64_t commandHash; // 生成该文件的完整命令的哈希
+    uint64_t inputHash;   // 生成时所有输入文件的指纹
+    uint64_t durationMs;  // 生成该文件的耗时（毫秒），0 表示没有记录
+    uint64_t peakMemoryKb; // 生成时编译器或链接器的峰值内存（KB），0 表示没有记录
+};
+
+// 持久化的构建日志
+// 文件中的记录按 key 排序，加载时直接映射文件，查询时二分查找，
+// 不需要逐条解析；本次构建的新记录保存在内存中，构建结束时合并写回
+class BuildLog {
+public:
+    BuildLog();
+    ~BuildLog();
+    
+    // 加载构建日志，文件不存在时视为空日志
+    bool load(const std::string& filename);
+    
+    // 查找输出文件的记录，没有记录时返回 false
+    bool find(const std::string& output, BuildLogEntry& entry) const;
+    
+    // 记录输出文件的构建命令、输入指纹、耗时和峰值内存
+    void record(const std::string& output, uint64_t commandHash, uint64_t inputHash, uint64_t durationMs = 0,
+                uint64_t peakMemoryKb = 0);
+    
+    // 将日志写回文件
+    bool save();
+    
+private:
+    std::string filename;
+    const BuildLogEntry* entries;
+    size_t entryCount;
+    void* mapping;
+    size_t mappingSize;
+    std::vector<BuildLogEntry> buffer;
+    std::map<uint64_t, BuildLogEntry> updates;
+    mutable std::mutex mutex;
+    
+    void unload();
+};
+
+#endif // BUILDLOG_HPP
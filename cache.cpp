@@ -0,0 +1,157 @@
+#include "cache.hpp"
+#include "fsutil.hpp"
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <process.h>
+#define getpid _getpid
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+ObjectCache::ObjectCache(const std::string& dir, uint64_t maxSizeBytes)
+    : cacheDir(dir), maxSize(maxSizeBytes), hitCount(0), missCount(0), storeCount(0) {
+    // 展开 ~ 为用户主目录
+    if (cacheDir.size() >= 2 && cacheDir[0] == '~' && (cacheDir[1] == '/' || cacheDir[1] == '\\')) {
+        const char* home = std::getenv("HOME");
+        if (home) {
+            cacheDir = std::string(home) + cacheDir.substr(1);
+        }
+    }
+}
+
+std::string ObjectCache::entryPath(uint64_t key, bool createDir) {
+    char hex[17];
+    snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(key));
+    std::string dir = cacheDir + "/" + std::string(hex, 2);
+    if (createDir) {
+        createDirectories(dir);
+    }
+    return dir + "/" + std::string(hex + 2);
+}
+
+bool ObjectCache::restore(uint64_t key, const std::string& objectFile, const std::string& depFile) {
+    std::string entry = entryPath(key, false);
+    std::string cachedObject = entry + ".o";
+    std::string cachedDep = entry + ".d";
+    
+    // 硬链接的目标文件在重新编译前会被删除，不会改写缓存中的内容
+    if (!cloneFile(cachedObject, objectFile, true) || !cloneFile(cachedDep, depFile, true)) {
+        std::remove(objectFile.c_str());
+        std::remove(depFile.c_str());
+        missCount++;
+        return false;
+    }
+    
+    // 更新修改时间：目标文件要比源文件新，缓存条目记录最近使用时间
+    touchFile(objectFile);
+    touchFile(cachedObject);
+    hitCount++;
+    return true;
+}
+
+bool ObjectCache::store(uint64_t key, const std::string& objectFile, const std::string& depFile) {
+    std::string entry = entryPath(key, true);
+    
+    // 先写入临时文件再重命名，其他进程不会读到不完整的条目
+    std::string suffix = ".tmp" + std::to_string(getpid()) + "_" + std::to_string(storeCount++);
+    if (!cloneFile(depFile, entry + ".d" + suffix, false) ||
+        !cloneFile(objectFile, entry + ".o" + suffix, false)) {
+        std::remove((entry + ".d" + suffix).c_str());
+        std::remove((entry + ".o" + suffix).c_str());
+        return false;
+    }
+    
+    // 先放入依赖文件：只有目标文件存在的条目才会被查找
+    bool ok = std::rename((entry + ".d" + suffix).c_str(), (entry + ".d").c_str()) == 0 &&
+              std::rename((entry + ".o" + suffix).c_str(), (entry + ".o").c_str()) == 0;
+    if (!ok) {
+        std::remove((entry + ".d" + suffix).c_str());
+        std::remove((entry + ".o" + suffix).c_str());
+    }
+    return ok;
+}
+
+void ObjectCache::trim() {
+    if (!enabled() || storeCount == 0 || maxSize == 0) {
+        return;
+    }
+    
+    struct CacheFile {
+        std::string path;
+        time_t modTime;
+        uint64_t size;
+    };
+    std::vector<CacheFile> files;
+    uint64_t totalSize = 0;
+    
+    for (int i = 0; i < 256; i++) {
+        char sub[3];
+        snprintf(sub, sizeof(sub), "%02x", i);
+        std::string dir = cacheDir + "/" + sub;
+        
+#ifdef _WIN32
+        WIN32_FIND_DATA findData;
+        HANDLE hFind = FindFirstFile((dir + "\\*.o").c_str(), &findData);
+        if (hFind == INVALID_HANDLE_VALUE) continue;
+        do {
+            std::string name = findData.cFileName;
+#else
+        DIR* handle = opendir(dir.c_str());
+        if (!handle) continue;
+        struct dirent* dirEntry;
+        while ((dirEntry = readdir(handle)) != nullptr) {
+            std::string name = dirEntry->d_name;
+            if (name.size() < 3 || name.compare(name.size() - 2, 2, ".o") != 0) continue;
+#endif
+            CacheFile file;
+            file.path = dir + "/" + name;
+            struct stat info;
+            if (stat(file.path.c_str(), &info) != 0) continue;
+            file.modTime = info.st_mtime;
+            file.size = static_cast<uint64_t>(info.st_size);
+            
+            // 依赖文件随目标文件一起计算和删除
+            std::string depPath = file.path.substr(0, file.path.size() - 2) + ".d";
+            if (stat(depPath.c_str(), &info) == 0) {
+                file.size += static_cast<uint64_t>(info.st_size);
+            }
+            totalSize += file.size;
+            files.push_back(file);
+#ifdef _WIN32
+        } while (FindNextFile(hFind, &findData));
+        FindClose(hFind);
+#else
+        }
+        closedir(handle);
+#endif
+    }
+    
+    if (totalSize <= maxSize) {
+        return;
+    }
+    
+    // 删除最久未使用的条目，直到低于上限的90%
+    std::sort(files.begin(), files.end(), [](const CacheFile& a, const CacheFile& b) {
+        return a.modTime < b.modTime;
+    });
+    uint64_t target = maxSize / 10 * 9;
+    size_t removed = 0;
+    for (const auto& file : files) {
+        if (totalSize <= target) break;
+        std::remove(file.path.c_str());
+        std::remove((file.path.substr(0, file.path.size() - 2) + ".d").c_str());
+        totalSize -= file.size;
+        removed++;
+    }
+    std::cout << "Cache: evicted " << removed << " entries" << std::endl;
+}
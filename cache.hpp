@@ -0,0 +1,41 @@
+#ifndef CACHE_HPP
+#define CACHE_HPP
+
+#include <string>
+#include <atomic>
+#include <cstdint>
+
+// 本地编译缓存
+// 以预处理后的源文件、编译命令和编译器版本计算的哈希为键保存目标文件，
+// 命中时通过 reflink、硬链接或复制恢复目标文件，不再调用编译器
+class ObjectCache {
+public:
+    ObjectCache(const std::string& cacheDir, uint64_t maxSizeBytes);
+    
+    // 是否启用缓存（配置了缓存目录）
+    bool enabled() const { return !cacheDir.empty(); }
+    
+    // 查找缓存，命中时恢复目标文件和依赖文件
+    bool restore(uint64_t key, const std::string& objectFile, const std::string& depFile);
+    
+    // 保存编译结果
+    bool store(uint64_t key, const std::string& objectFile, const std::string& depFile);
+    
+    // 缓存超过大小上限时删除最久未使用的条目
+    void trim();
+    
+    size_t hits() const { return hitCount; }
+    size_t misses() const { return missCount; }
+    
+private:
+    std::string cacheDir;
+    uint64_t maxSize;
+    std::atomic<size_t> hitCount;
+    std::atomic<size_t> missCount;
+    std::atomic<size_t> storeCount;
+    
+    // 缓存条目的路径（不含扩展名），按哈希前两位分子目录
+    std::string entryPath(uint64_t key, bool createDir);
+};
+
+#endif // CACHE_HPP
@@ -1,7 +1,18 @@
 #include "compiler.hpp"
+#include "filehash.hpp"
+#include "hash.hpp"
+#include "fsutil.hpp"
+#include "process.hpp"
+#include "trace.hpp"
+#include "filestat.hpp"
 #include <iostream>
 #include <sstream>
 #include <cstdlib>
+#include <cstdio>
+#include <algorithm>
+#include <set>
+#include <fstream>
+#include <chrono>
 
 #ifdef _WIN32
 #include <direct.h>
@@ -12,17 +23,36 @@
 #include <sys/types.h>
 #endif
 
-Compiler::Compiler(const BuildConfig& config) : config(config) {
+// 没有耗时记录的任务按源文件大小和 #include 的数量估计耗时（毫秒）
+static const uint64_t ESTIMATE_BASE_MS = 100;
+static const uint64_t ESTIMATE_MS_PER_KB = 10;
+static const uint64_t ESTIMATE_MS_PER_INCLUDE = 150;
+static const uint64_t ESTIMATE_LINK_MS_PER_INPUT = 5;
+
+// 没有峰值内存记录的任务按此估计（KB）
+static const uint64_t ESTIMATE_MEMORY_KB = 512 * 1024;
+
+// 从 start 到现在经过的毫秒数，至少为 1（0 表示没有记录）
+static uint64_t elapsedMs(std::chrono::steady_clock::time_point start) {
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    return std::max<uint64_t>(1, static_cast<uint64_t>(elapsed.count()));
+}
+
+Compiler::Compiler(const BuildConfig& config, BuildTrace* trace)
+    : config(config),
+      trace(trace),
+      cancelFlag(nullptr),
+      objectCache(config.cache_dir, static_cast<uint64_t>(config.cache_max_size_mb) * 1024 * 1024),
+      remoteWorkers(config.workers),
+      compilerIdentity(0),
+      linkerResolved(false) {
+    depChecker.setContentHashing(config.dirty_check == "hash");
 }
 
 bool Compiler::createBuildDir() {
     if (!depChecker.fileExists(config.build_dir)) {
         std::cout << "Creating build directory: " << config.build_dir << std::endl;
-#ifdef _WIN32
-        if (_mkdir(config.build_dir.c_str()) != 0) {
-#else
-        if (mkdir(config.build_dir.c_str(), 0755) != 0) {
-#endif
+        if (!createDirectories(config.build_dir)) {
             std::cerr << "Error: Failed to create build directory" << std::endl;
             return false;
         }
@@ -31,18 +61,124 @@ bool Compiler::createBuildDir() {
 }
 
 std::string Compiler::getObjectFilePath(const std::string& sourceFile) {
-    // 从源文件路径提取文件名
-    size_t lastSlash = sourceFile.find_last_of("/\\");
-    std::string filename = (lastSlash != std::string::npos) ? 
-                          sourceFile.substr(lastSlash + 1) : sourceFile;
+    // 构建目录中生成的源文件（unity 文件）使用相对于构建目录的路径
+    std::string path = sourceFile;
+    std::string prefix = config.build_dir + "/";
+    if (path.compare(0, prefix.size(), prefix) == 0) {
+        path = path.substr(prefix.size());
+    }
     
-    // 替换扩展名为 .o
-    size_t lastDot = filename.find_last_of(".");
-    if (lastDot != std::string::npos) {
-        filename = filename.substr(0, lastDot);
+    // 在 obj/ 下按源文件的目录结构存放，不同目录中的同名文件不会冲突；
+    // 保留源文件扩展名，同一目录中的 a.cpp 和 a.cc 也不会冲突
+    std::string relative;
+    if (!path.empty() && (path[0] == '/' || path[0] == '\\')) {
+        relative = "_root";
+    }
+    size_t start = 0;
+    while (start <= path.size()) {
+        size_t end = path.find_first_of("/\\", start);
+        if (end == std::string::npos) {
+            end = path.size();
+        }
+        std::string part = path.substr(start, end - start);
+        start = end + 1;
+        if (part.empty() || part == ".") {
+            continue;
+        }
+        // 源目录之外的文件：.. 替换为 __，Windows 的盘符去掉冒号
+        if (part == "..") {
+            part = "__";
+        } else if (part.size() == 2 && part[1] == ':') {
+            part = std::string(1, part[0]) + "_";
+        }
+        relative += (relative.empty() ? "" : "/") + part;
+    }
+    
+    return config.build_dir + "/obj/" + relative + ".o";
+}
+
+std::string Compiler::getDepFilePath(const std::string& objectFile) {
+    size_t lastDot = objectFile.find_last_of(".");
+    size_t lastSlash = objectFile.find_last_of("/\\");
+    if (lastDot != std::string::npos && (lastSlash == std::string::npos || lastDot > lastSlash)) {
+        return objectFile.substr(0, lastDot) + ".d";
+    }
+    return objectFile + ".d";
+}
+
+bool Compiler::isClang() {
+    return config.compiler.find("clang") != std::string::npos;
+}
+
+std::string Compiler::getPchHeaderPath() {
+    size_t lastSlash = config.precompiled_header.find_last_of("/\\");
+    std::string filename = (lastSlash != std::string::npos) ?
+                          config.precompiled_header.substr(lastSlash + 1) : config.precompiled_header;
+    return config.build_dir + "/pch/" + filename;
+}
+
+std::string Compiler::getPchOutputPath() {
+    return getPchHeaderPath() + (isClang() ? ".pch" : ".gch");
+}
+
+std::vector<std::string> Compiler::getExtraInputs(const std::string& objectFile) {
+    std::vector<std::string> inputs;
+    if (!config.precompiled_header.empty()) {
+        inputs.push_back(getPchOutputPath());
+    }
+    // 训练数据更新后只有使用它的优化构建需要重新编译
+    std::string profile = getProfileDataPath(objectFile);
+    if (!profile.empty()) {
+        inputs.push_back(profile);
+    }
+    return inputs;
+}
+
+std::string Compiler::getProfileDataPath(const std::string& objectFile) {
+    if (config.pgo_dir.empty() || config.pgo_instrument) {
+        return "";
+    }
+    std::string profile = isClang() ? config.pgo_dir + "/default.profdata" :
+                                      objectFile.substr(0, objectFile.find_last_of('.')) + ".gcda";
+    // 训练数据同时是编译的输入，使用快照，每个目标文件多次查询也只 stat 一次
+    return depChecker.inputExists(profile) ? profile : "";
+}
+
+uint64_t Compiler::estimateCompileTime(const std::string& sourceFile, const std::string& objectFile) {
+    uint64_t recorded = depChecker.getDuration(objectFile);
+    if (recorded > 0) {
+        return recorded;
     }
     
-    return config.build_dir + "/" + filename + ".o";
+    // 只统计源文件中直接的 #include，合并编译的源文件按其中包含的源文件数估计
+    std::ifstream in(sourceFile);
+    std::string line;
+    uint64_t bytes = 0;
+    uint64_t includes = 0;
+    while (std::getline(in, line)) {
+        bytes += line.size() + 1;
+        size_t pos = line.find_first_not_of(" \t");
+        if (pos != std::string::npos && line[pos] == '#') {
+            pos = line.find_first_not_of(" \t", pos + 1);
+            if (pos != std::string::npos && line.compare(pos, 7, "include") == 0) {
+                includes++;
+            }
+        }
+    }
+    return ESTIMATE_BASE_MS + bytes / 1024 * ESTIMATE_MS_PER_KB + includes * ESTIMATE_MS_PER_INCLUDE;
+}
+
+uint64_t Compiler::estimateLinkTime(const std::vector<std::string>& inputs) {
+    uint64_t recorded = depChecker.getDuration(getOutputFilePath());
+    if (recorded > 0) {
+        return recorded;
+    }
+    return ESTIMATE_BASE_MS + inputs.size() * ESTIMATE_LINK_MS_PER_INPUT;
+}
+
+uint64_t Compiler::estimateMemory(const std::string& outputFile) {
+    uint64_t recorded = depChecker.getPeakMemory(outputFile);
+    return recorded > 0 ? recorded : ESTIMATE_MEMORY_KB;
 }
 
 std::string Compiler::getOutputFilePath() {
@@ -52,119 +188,657 @@ std::string Compiler::getOutputFilePath() {
 #ifdef _WIN32
     if (config.output_type == "executable") {
         outputName += ".exe";
+    } else if (config.output_type == "static_library") {
+        outputName = "lib" + outputName + ".a";
     } else {
         outputName += ".dll";
     }
 #else
     if (config.output_type == "library") {
         outputName = "lib" + outputName + ".so";
+    } else if (config.output_type == "static_library") {
+        outputName = "lib" + outputName + ".a";
     }
 #endif
     
-    return config.build_dir + "/" + outputName;
+    return (config.output_dir.empty() ? config.build_dir : config.output_dir) + "/" + outputName;
 }
 
-std::string Compiler::buildCompileCommand(const std::string& sourceFile, 
-                                         const std::string& objectFile) {
-    std::stringstream cmd;
-    cmd << config.compiler << " ";
+void Compiler::addLinkInput(const std::string& file) {
+    extraLinkInputs.push_back(file);
+}
+
+std::vector<std::string> Compiler::buildCompileFlags() {
+    // 编译器可以带前缀命令或参数（如 "ccache g++"）
+    std::vector<std::string> cmd = splitArgs(config.compiler);
     
     // C++ 标准
-    cmd << "-std=" << config.cpp_standard << " ";
+    cmd.push_back("-std=" + config.cpp_standard);
     
     // 优化级别
-    cmd << "-" << config.optimization << " ";
+    cmd.push_back("-" + config.optimization);
+    
+    // 链接时优化：目标文件中保存中间表示，链接时再统一优化和生成代码
+    if (config.lto == "full") {
+        cmd.push_back("-flto");
+    } else if (config.lto == "thin") {
+        cmd.push_back(isClang() ? "-flto=thin" : "-flto");
+    }
     
     // 调试信息
     if (config.debug) {
-        cmd << "-g ";
+        cmd.push_back("-g");
+        // .dwo 文件不压缩：dwp 工具通常无法读取压缩的 .dwo，调试信息在打包或链接时再压缩
+        if (useSplitDwarf()) {
+            cmd.push_back("-gsplit-dwarf");
+        } else if (config.compress_debug_sections) {
+            cmd.push_back("-gz");
+        }
     }
     
     // 包含目录
     for (const auto& includeDir : config.include_dirs) {
-        cmd << "-I" << includeDir << " ";
+        cmd.push_back("-I" + includeDir);
     }
     
-    // 额外的编译标志
+    // 额外的编译标志（一项中可以包含多个参数，如 "-include config.h"）
     for (const auto& flag : config.compile_flags) {
-        cmd << flag << " ";
+        for (const auto& arg : splitArgs(flag)) {
+            cmd.push_back(arg);
+        }
+    }
+    
+    return cmd;
+}
+
+std::vector<std::string> Compiler::buildCompileCommand(const std::string& sourceFile, 
+                                                      const std::string& objectFile) {
+    std::vector<std::string> cmd = buildCompileFlags();
+    
+    // 预编译头
+    if (!config.precompiled_header.empty()) {
+        if (isClang()) {
+            cmd.insert(cmd.end(), {"-include-pch", getPchOutputPath()});
+        } else {
+            cmd.insert(cmd.end(), {"-include", getPchHeaderPath(), "-Winvalid-pch"});
+        }
     }
     
+    // PGO：插桩构建记录运行数据，之后的构建使用训练得到的数据
+    // GCC 在目标文件旁读写同名的 .gcda；clang 把原始数据写入 pgo/raw，合并后读取 .profdata
+    if (config.pgo_instrument) {
+        cmd.push_back(isClang() ? "-fprofile-generate=" + absolutePath(config.pgo_dir + "/raw") :
+                                  "-fprofile-generate");
+    } else {
+        std::string profile = getProfileDataPath(objectFile);
+        if (!profile.empty()) {
+            cmd.push_back(isClang() ? "-fprofile-use=" + profile : "-fprofile-use");
+        }
+    }
+    
+    // 生成头文件依赖信息
+    cmd.insert(cmd.end(), {"-MMD", "-MF", getDepFilePath(objectFile)});
+    
     // 编译为目标文件
-    cmd << "-c " << sourceFile << " -o " << objectFile;
+    cmd.insert(cmd.end(), {"-c", sourceFile, "-o", objectFile});
     
-    return cmd.str();
+    return cmd;
 }
 
-std::string Compiler::buildLinkCommand() {
-    std::stringstream cmd;
-    cmd << config.compiler << " ";
+std::vector<std::string> Compiler::buildPchCommand() {
+    std::string pchOutput = getPchOutputPath();
+    std::vector<std::string> cmd = buildCompileFlags();
+    cmd.insert(cmd.end(), {"-x", "c++-header", getPchHeaderPath(),
+                           "-MMD", "-MF", getDepFilePath(pchOutput), "-o", pchOutput});
+    return cmd;
+}
+
+std::vector<std::string> Compiler::buildPreprocessCommand(const std::string& sourceFile,
+                                                         const std::string& outputFile) {
+    std::vector<std::string> cmd = buildCompileFlags();
     
-    // 所有目标文件
-    for (const auto& objFile : objectFiles) {
-        cmd << objFile << " ";
+    // 预编译头按文本包含，使缓存键覆盖其内容
+    if (!config.precompiled_header.empty()) {
+        cmd.insert(cmd.end(), {"-include", config.precompiled_header});
     }
+    cmd.insert(cmd.end(), {"-E", sourceFile, "-o", outputFile});
+    return cmd;
+}
+
+uint64_t Compiler::getCompilerIdentity() {
+    std::call_once(compilerIdentityOnce, [this]() {
+        std::vector<std::string> command = splitArgs(config.compiler);
+        command.push_back("--version");
+        std::string output;
+        executeCommand(command, output);
+        compilerIdentity = hashString(output);
+    });
+    return compilerIdentity;
+}
+
+std::vector<std::string> Compiler::buildRemoteCompileFlags() {
+    std::vector<std::string> flags = buildCompileFlags();
+    
+    // 编译器启动器在本机使用，工作进程只运行编译器本身
+    while (flags.size() > 1) {
+        std::string name = flags[0].substr(flags[0].find_last_of("/\\") + 1);
+        if (name != "ccache" && name != "sccache" && name != "distcc") {
+            break;
+        }
+        flags.erase(flags.begin());
+    }
+    flags[0] = flags[0].substr(flags[0].find_last_of("/\\") + 1);
+    
+    // 预处理结果中已经包含了头文件和宏定义
+    static const std::set<std::string> preprocessorOptions = {
+        "-include", "-imacros", "-isystem", "-iquote", "-idirafter", "-I", "-D", "-U"
+    };
+    std::vector<std::string> remote = {flags[0]};
+    for (size_t i = 1; i < flags.size(); i++) {
+        const std::string& flag = flags[i];
+        if (preprocessorOptions.count(flag)) {
+            i++;
+        } else if (flag.compare(0, 2, "-I") != 0 && flag.compare(0, 2, "-D") != 0 &&
+                   flag.compare(0, 2, "-U") != 0 && flag.compare(0, 8, "-isystem") != 0 &&
+                   flag.compare(0, 7, "-iquote") != 0) {
+            remote.push_back(flag);
+        }
+    }
+    return remote;
+}
+
+bool Compiler::preprocessSource(const std::string& sourceFile, const std::string& objectFile,
+                                const std::string& preprocessed) {
+    std::vector<std::string> command = buildPreprocessCommand(sourceFile, preprocessed);
+    command.insert(command.end(), {"-MMD", "-MF", getDepFilePath(objectFile), "-MT", objectFile});
+    
+    // 预处理失败时不使用缓存和工作进程，由正常编译报告错误
+    std::string ppOutput;
+    if (!executeCommand(command, ppOutput)) {
+        std::remove(preprocessed.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool Compiler::computeCacheKey(const std::string& sourceFile, const std::string& preprocessed,
+                               uint64_t& key) {
+    uint64_t contentHash;
+    if (!FileHashCache::hashContents(preprocessed, contentHash)) {
+        return false;
+    }
+    
+    // 命令中的目标文件路径替换为固定占位符，不同构建目录可以共享缓存
+    std::string command = joinArgs(buildCompileCommand(sourceFile, "@OBJECT@"));
+    key = hashCombine(hashString(command, getCompilerIdentity()), contentHash);
+    return true;
+}
+
+std::vector<std::string> Compiler::buildArchiveCommand(const std::vector<std::string>& members) {
+    // r 替换同名成员（没有时追加），c 不提示创建，s 更新符号索引；
+    // P 按完整路径匹配成员，不同目录中的同名目标文件不会互相替换（macOS 的 ar 不支持）
+#ifdef __APPLE__
+    std::vector<std::string> cmd = {getArchiver(), "rcs"};
+#else
+    std::vector<std::string> cmd = {getArchiver(), "rcsP"};
+#endif
+    if (config.thin_archive) {
+        cmd.push_back("--thin");
+    }
+    cmd.push_back(getOutputFilePath());
+    cmd.insert(cmd.end(), members.begin(), members.end());
+    return cmd;
+}
+
+std::vector<std::string> Compiler::buildLinkCommand() {
+    if (config.output_type == "static_library") {
+        return buildArchiveCommand(objectFiles);
+    }
+    
+    std::vector<std::string> cmd = splitArgs(config.compiler);
+    
+    // 所有目标文件，然后是依赖的其他目标生成的库
+    cmd.insert(cmd.end(), objectFiles.begin(), objectFiles.end());
+    cmd.insert(cmd.end(), extraLinkInputs.begin(), extraLinkInputs.end());
     
     // 库目录
     for (const auto& libDir : config.library_dirs) {
-        cmd << "-L" << libDir << " ";
+        cmd.push_back("-L" + libDir);
     }
     
     // 库文件
     for (const auto& lib : config.libraries) {
-        cmd << "-l" << lib << " ";
+        cmd.push_back("-l" + lib);
+    }
+    
+    // 链接器
+    std::string linker = getLinker();
+    if (!linkerSearchDir.empty()) {
+        cmd.push_back("-B" + linkerSearchDir);
+    } else if (!linker.empty()) {
+        cmd.push_back("-fuse-ld=" + linker);
+    }
+    if (config.debug && config.compress_debug_sections) {
+        cmd.push_back("-gz");
+    }
+    
+    // 链接时优化的代码生成按并行任务数分区并行执行
+    if (config.lto != "off") {
+        std::vector<std::string> ltoFlags = buildLtoLinkFlags(linker);
+        cmd.insert(cmd.end(), ltoFlags.begin(), ltoFlags.end());
+    }
+    
+    // 插桩的目标文件需要链接记录运行数据的运行时库
+    if (config.pgo_instrument) {
+        cmd.push_back("-fprofile-generate");
     }
     
     // 额外的链接标志
     for (const auto& flag : config.link_flags) {
-        cmd << flag << " ";
+        for (const auto& arg : splitArgs(flag)) {
+            cmd.push_back(arg);
+        }
     }
     
     // 输出文件
-    cmd << "-o " << getOutputFilePath();
+    cmd.insert(cmd.end(), {"-o", getOutputFilePath()});
     
     // 如果是共享库
     if (config.output_type == "library") {
-        cmd << " -shared";
+        cmd.push_back("-shared");
+        
+        // 其他目标按路径链接共享库，以文件名作为运行时查找的名称
+        std::string output = getOutputFilePath();
+        std::string fileName = output.substr(output.find_last_of('/') + 1);
+#ifdef __APPLE__
+        cmd.push_back("-Wl,-install_name,@rpath/" + fileName);
+#elif !defined(_WIN32)
+        cmd.push_back("-Wl,-soname," + fileName);
+#endif
+    }
+    
+    return cmd;
+}
+
+std::string Compiler::getLinker() {
+    if (!linkerResolved) {
+        linkerResolved = true;
+        if (config.linker == "auto") {
+            // 只查找 PATH 和文件，不启动进程（不检查 GCC 的版本），没有修改的构建仍然不会启动任何进程。
+            // GCC 使用 mold 安装在 <前缀>/libexec/mold/ld 的链接器，所有版本的 GCC 都支持 -B
+            std::string mold = findExecutable("ld.mold");
+            if (!mold.empty() && !isClang()) {
+                std::string binDir = mold.substr(0, mold.find_last_of('/'));
+                std::string prefix = binDir.substr(0, binDir.find_last_of('/'));
+                for (const char* dir : {"/libexec/mold", "/lib/mold"}) {
+                    if (statPath(prefix + dir + "/ld").exists) {
+                        linkerSearchDir = prefix + dir;
+                        break;
+                    }
+                }
+            }
+            // lld 没有 GCC 的 LTO 插件，不能链接 GCC 生成的 LTO 目标文件
+            bool gccLto = !isClang() && config.lto != "off";
+            if (!mold.empty() && (isClang() || !linkerSearchDir.empty())) {
+                linkerName = "mold";
+            } else if (!gccLto && !findExecutable("ld.lld").empty()) {
+                linkerName = "lld";
+            }
+        } else if (config.linker != "default") {
+            linkerName = config.linker;
+        }
+    }
+    return linkerName;
+}
+
+std::vector<std::string> Compiler::buildLtoLinkFlags(const std::string& linker) {
+    // 链接在本机进行；有工作进程时 jobs 包括在其他机器上运行的编译任务，不超过本机的默认并行数
+    int linkJobs = config.jobs > 0 ? config.jobs : JobScheduler::defaultJobCount();
+    if (!config.workers.empty()) {
+        linkJobs = std::min(linkJobs, JobScheduler::defaultJobCount());
+    }
+    std::string jobs = std::to_string(linkJobs);
+    if (!isClang()) {
+        // GCC 没有 ThinLTO，thin 同样使用分区并行的 LTO
+        return {"-flto=" + jobs};
+    }
+    if (config.lto == "full") {
+        return {"-flto"};
+    }
+    
+    // ThinLTO：每个模块单独优化，结果缓存在构建目录中，重新链接时只处理发生变化的模块
+    std::string cacheDir = config.build_dir + "/lto-cache";
+    std::vector<std::string> flags = {"-flto=thin"};
+#ifdef __APPLE__
+    flags.push_back("-Wl,-cache_path_lto," + cacheDir);
+    flags.push_back("-Wl,-mllvm,-threads=" + jobs);
+#else
+    if (linker == "lld") {
+        flags.push_back("-Wl,--thinlto-jobs=" + jobs);
+        flags.push_back("-Wl,--thinlto-cache-dir=" + cacheDir);
+    } else {
+        // bfd、gold 和 mold 通过 LLVM 的链接器插件执行 ThinLTO
+        flags.push_back("-Wl,-plugin-opt,jobs=" + jobs);
+        flags.push_back("-Wl,-plugin-opt,cache-dir=" + cacheDir);
+    }
+#endif
+    return flags;
+}
+
+std::string Compiler::getArchiver() {
+    // 普通的 ar 不一定能读取 LTO 目标文件中的符号，改用编译器提供的包装（找不到时仍使用 ar）
+    if (config.lto != "off") {
+        std::string archiver = isClang() ? "llvm-ar" : "gcc-ar";
+        if (!findExecutable(archiver).empty()) {
+            return archiver;
+        }
+    }
+    return "ar";
+}
+
+bool Compiler::useSplitDwarf() {
+    return config.debug && config.split_dwarf;
+}
+
+bool Compiler::packageDebugInfo(std::string& output) {
+    // binutils 的 dwp 不支持 DWARF 5（GCC 11 起的默认版本），优先使用 llvm-dwp
+    std::string outputFile = getOutputFilePath();
+    std::string tool = findExecutable("llvm-dwp").empty() ? "dwp" : "llvm-dwp";
+    std::vector<std::string> command = {tool, "-e", outputFile, "-o", outputFile + ".dwp"};
+    return executeCommand(command, output);
+}
+
+std::vector<std::string> Compiler::getLinkInputs() {
+    std::vector<std::string> inputs = objectFiles;
+    if (config.output_type == "static_library") {
+        return inputs;
+    }
+    inputs.insert(inputs.end(), extraLinkInputs.begin(), extraLinkInputs.end());
+    
+    // 按链接器的查找顺序取第一个存在的库文件；系统目录中的库不跟踪
+    for (const auto& lib : config.libraries) {
+#ifdef _WIN32
+        const std::string candidates[] = {lib + ".lib", "lib" + lib + ".a"};
+#else
+        const std::string candidates[] = {"lib" + lib + ".so", "lib" + lib + ".a"};
+#endif
+        bool found = false;
+        for (const auto& libDir : config.library_dirs) {
+            for (const auto& candidate : candidates) {
+                std::string path = libDir + "/" + candidate;
+                if (depChecker.fileExists(path)) {
+                    inputs.push_back(path);
+                    found = true;
+                    break;
+                }
+            }
+            if (found) {
+                break;
+            }
+        }
+    }
+    
+    return inputs;
+}
+
+bool Compiler::executeCommand(const std::vector<std::string>& command, std::string& output,
+                              const std::string& responseFile, uint64_t* peakMemoryKb) {
+    output += "Executing: " + joinArgs(command) + "\n";
+    return runProcess(command, output, responseFile, peakMemoryKb);
+}
+
+std::vector<std::string> Compiler::getTranslationUnits() {
+    unityMemberCounts.clear();
+    if (config.unity_batch_size <= 0) {
+        return config.source_files;
+    }
+    
+    std::vector<std::string> units;
+    std::vector<std::string> members;
+    std::set<std::string> excluded(config.unity_exclude.begin(), config.unity_exclude.end());
+    for (const auto& sourceFile : config.source_files) {
+        if (excluded.count(sourceFile)) {
+            units.push_back(sourceFile);
+        } else {
+            members.push_back(sourceFile);
+        }
+    }
+    std::sort(members.begin(), members.end());
+    
+    // 按文件路径的哈希决定批次边界，而不是每 N 个文件一批：
+    // 增删一个文件只影响它所在的批次，不会使之后的所有批次都发生变化
+    size_t batchSize = static_cast<size_t>(config.unity_batch_size);
+    size_t minSize = std::max<size_t>(1, batchSize / 2);
+    std::vector<std::vector<std::string>> batches(1);
+    for (const auto& member : members) {
+        std::vector<std::string>& batch = batches.back();
+        batch.push_back(member);
+        bool boundary = batchSize <= 2 || hashString(member) % batchSize < 2;
+        if ((batch.size() >= minSize && boundary) || batch.size() >= batchSize * 2) {
+            batches.emplace_back();
+        }
+    }
+    
+    createDirectories(config.build_dir + "/unity");
+    for (const auto& batch : batches) {
+        if (batch.empty()) {
+            continue;
+        }
+        if (batch.size() == 1) {
+            units.push_back(batch.front());
+            continue;
+        }
+        
+        // 合并文件以第一个成员命名，成员不变时文件名和内容都不变
+        char name[32];
+        snprintf(name, sizeof(name), "unity_%016llx.cpp",
+                 static_cast<unsigned long long>(hashString(batch.front())));
+        std::string unityFile = config.build_dir + "/unity/" + name;
+        
+        std::string content = "// Generated by buildpp for unity build. Do not edit.\n";
+        for (const auto& member : batch) {
+            content += "#include \"" + absolutePath(member) + "\"\n";
+        }
+        writeFileIfChanged(unityFile, content);
+        depChecker.invalidateFile(unityFile);
+        
+        units.push_back(unityFile);
+        unityMemberCounts[unityFile] = batch.size();
     }
     
-    return cmd.str();
+    return units;
 }
 
-bool Compiler::executeCommand(const std::string& command) {
-    std::cout << "Executing: " << command << std::endl;
-    int result = system(command.c_str());
-    return result == 0;
+bool Compiler::compilePch(std::string& output) {
+    std::string pchOutput = getPchOutputPath();
+    std::vector<std::string> command = buildPchCommand();
+    auto start = std::chrono::steady_clock::now();
+    
+    std::remove(pchOutput.c_str());
+    uint64_t peakMemoryKb = 0;
+    if (!executeCommand(command, output, "", &peakMemoryKb)) {
+        output += "Error: Failed to compile precompiled header " + config.precompiled_header + "\n";
+        return false;
+    }
+    
+    if (!depChecker.recordCompile(pchOutput, getDepFilePath(pchOutput), joinArgs(command),
+                                  std::vector<std::string>(), elapsedMs(start), peakMemoryKb)) {
+        output += "Warning: Cannot read dependency file for " + config.precompiled_header + "\n";
+    }
+    return true;
 }
 
 bool Compiler::compileSource(const std::string& sourceFile, 
-                            const std::string& objectFile) {
-    // 检查是否需要重新编译
-    if (!depChecker.needsRecompile(sourceFile, objectFile)) {
-        std::cout << "Skipping " << sourceFile << " (up to date)" << std::endl;
+                            const std::string& objectFile,
+                            std::string& output) {
+    std::vector<std::string> command = buildCompileCommand(sourceFile, objectFile);
+    std::string depFile = getDepFilePath(objectFile);
+    auto compileStart = std::chrono::steady_clock::now();
+    
+    // 缓存和工作进程都不处理 .dwo 文件，分离调试信息时只在本机编译且不使用缓存。
+    // 缓存键不包括 PGO 训练数据，插桩构建和使用训练数据编译时同样不使用缓存和工作进程
+    bool timeTrace = trace && trace->enabled() && isClang();
+    bool local = useSplitDwarf() || config.pgo_instrument || !getProfileDataPath(objectFile).empty();
+    bool cacheable = objectCache.enabled() && !local;
+    bool distributable = remoteWorkers.enabled() && !local && !timeTrace;
+    
+    // 依赖文件可能是缓存条目的硬链接，先删除以免预处理或编译时 -MF 改写缓存中的依赖
+    std::remove(depFile.c_str());
+    
+    // 使用缓存或工作进程时预处理一次，预处理结果同时用于计算缓存键和发送到工作进程
+    std::string preprocessed = objectFile + ".ii";
+    bool preprocessedOk = (cacheable || distributable) && preprocessSource(sourceFile, objectFile, preprocessed);
+    
+    // 查找编译缓存，命中时直接恢复目标文件
+    uint64_t cacheKey = 0;
+    cacheable = cacheable && preprocessedOk && computeCacheKey(sourceFile, preprocessed, cacheKey);
+    if (cacheable && objectCache.restore(cacheKey, objectFile, depFile)) {
+        std::remove(preprocessed.c_str());
+        output += "Cache hit: " + sourceFile + "\n";
+        // 保留上次实际编译的耗时和峰值内存，缓存未命中时仍按编译的耗时和内存估计
+        depChecker.recordCompile(objectFile, depFile, joinArgs(command), getExtraInputs(objectFile),
+                                 depChecker.getDuration(objectFile), depChecker.getPeakMemory(objectFile));
+        return true;
+    }
+    
+    // 在工作进程上编译；依赖文件已在预处理时生成，记录的命令与本机编译相同，两者可以互换
+    bool remoteOk = distributable && preprocessedOk &&
+                    compileRemote(sourceFile, objectFile, preprocessed, output);
+    std::remove(preprocessed.c_str());
+    if (remoteOk) {
+        // 不占用本机内存，保留上次在本机编译的峰值内存，工作进程不可用时仍按它限制并行数
+        if (!depChecker.recordCompile(objectFile, depFile, joinArgs(command), getExtraInputs(objectFile),
+                                      elapsedMs(compileStart), depChecker.getPeakMemory(objectFile))) {
+            output += "Warning: Cannot read dependency file for " + sourceFile + "\n";
+        }
+        if (cacheable) {
+            objectCache.store(cacheKey, objectFile, depFile);
+        }
         return true;
     }
     
-    std::cout << "Compiling " << sourceFile << "..." << std::endl;
-    std::string command = buildCompileCommand(sourceFile, objectFile);
+    // 记录时间线时让 clang 输出编译过程各阶段的耗时（不影响目标文件，不计入命令哈希）
+    std::vector<std::string> runCommand = command;
+    int64_t start = timeTrace ? trace->now() : 0;
+    if (timeTrace) {
+        runCommand.push_back("-ftime-trace");
+    }
+    
+    // 目标文件可能是缓存条目的硬链接，先删除以免编译器改写缓存内容
+    std::remove(objectFile.c_str());
+    uint64_t peakMemoryKb = 0;
+    if (!executeCommand(runCommand, output, "", &peakMemoryKb)) {
+        output += "Error: Failed to compile " + sourceFile + "\n";
+        return false;
+    }
+    
+    // 记录此次编译的头文件依赖、编译命令、输入指纹、耗时和峰值内存
+    if (!depChecker.recordCompile(objectFile, depFile, joinArgs(command), getExtraInputs(objectFile),
+                                  elapsedMs(compileStart), peakMemoryKb)) {
+        output += "Warning: Cannot read dependency file for " + sourceFile + "\n";
+    }
+    
+    // clang 把耗时写入目标文件旁的同名 .json 文件
+    if (timeTrace) {
+        std::string timeTraceFile = objectFile.substr(0, objectFile.find_last_of('.')) + ".json";
+        trace->mergeClangTrace(timeTraceFile, start);
+        std::remove(timeTraceFile.c_str());
+    }
+    
+    if (cacheable) {
+        objectCache.store(cacheKey, objectFile, depFile);
+    }
+    
+    return true;
+}
+
+bool Compiler::compileRemote(const std::string& sourceFile, const std::string& objectFile,
+                             const std::string& preprocessed, std::string& output) {
+    std::ifstream in(preprocessed, std::ios::binary);
+    std::stringstream source;
+    source << in.rdbuf();
+    if (!in.good()) {
+        return false;
+    }
     
-    if (!executeCommand(command)) {
-        std::cerr << "Error: Failed to compile " << sourceFile << std::endl;
+    // 工作进程上的编译失败时丢弃其输出，本机重新编译时会再次报告错误
+    std::string object, remoteOutput, warnings;
+    bool compiled = remoteWorkers.compile(buildRemoteCompileFlags(), source.str(), object, remoteOutput, warnings);
+    output += warnings;
+    if (!compiled) {
         return false;
     }
     
+    // 先写入临时文件，写入失败时不会留下不完整的目标文件
+    std::string tempFile = objectFile + ".tmp";
+    std::ofstream out(tempFile, std::ios::binary | std::ios::trunc);
+    out.write(object.data(), object.size());
+    out.close();
+    std::remove(objectFile.c_str());
+    if (!out || std::rename(tempFile.c_str(), objectFile.c_str()) != 0) {
+        std::remove(tempFile.c_str());
+        output += "Warning: Cannot write the object file of " + sourceFile + " received from a worker\n";
+        return false;
+    }
+    output += remoteOutput;
     return true;
 }
 
-bool Compiler::linkObjects() {
-    std::cout << "\nLinking..." << std::endl;
-    std::string command = buildLinkCommand();
+bool Compiler::linkObjects(const std::vector<std::string>& command,
+                           const std::vector<std::string>& inputs, std::string& output) {
+    std::string outputFile = getOutputFilePath();
+    
+    // 重新编译的目标文件内容可能没有变化（哈希模式），此时仍然不需要重新链接
+    if (!depChecker.needsRelink(outputFile, joinArgs(command), inputs)) {
+        output += "Skipping " + outputFile + " (up to date)\n";
+        return true;
+    }
     
-    if (!executeCommand(command)) {
-        std::cerr << "Error: Failed to link" << std::endl;
+    auto start = std::chrono::steady_clock::now();
+    if (config.output_type == "static_library") {
+        if (!archiveObjects(command, inputs, output)) {
+            output += "Error: Failed to create archive " + outputFile + "\n";
+            return false;
+        }
+        depChecker.recordLink(outputFile, joinArgs(command), inputs, elapsedMs(start));
+        return true;
+    }
+    
+    // 目标文件很多时链接命令可能超过系统限制，改用响应文件传递参数
+    uint64_t peakMemoryKb = 0;
+    if (!executeCommand(command, output, config.build_dir + "/link.rsp", &peakMemoryKb)) {
+        output += "Error: Failed to link " + outputFile + "\n";
+        return false;
+    }
+    
+    if (useSplitDwarf() && config.dwp && !packageDebugInfo(output)) {
+        output += "Error: Failed to package debug info\n";
         return false;
     }
     
+    depChecker.recordLink(outputFile, joinArgs(command), inputs, elapsedMs(start), peakMemoryKb);
+    return true;
+}
+
+bool Compiler::archiveObjects(const std::vector<std::string>& command,
+                              const std::vector<std::string>& objects, std::string& output) {
+    std::string outputFile = getOutputFilePath();
+    std::vector<std::string> changed = depChecker.changedMembers(outputFile, joinArgs(command), objects);
+    
+    if (changed.size() == objects.size()) {
+        // 重新创建，旧的静态库中可能有已删除的源文件的成员
+        std::remove(outputFile.c_str());
+        if (!executeCommand(command, output, config.build_dir + "/link.rsp")) {
+            return false;
+        }
+    } else if (!changed.empty()) {
+        // 只替换变化的成员，不重新写入其他成员（thin archive 本来就只记录路径）
+        if (!executeCommand(buildArchiveCommand(changed), output, config.build_dir + "/link.rsp")) {
+            return false;
+        }
+    }
+    
+    depChecker.recordMembers(outputFile, objects);
     return true;
 }
 
@@ -173,52 +847,211 @@ bool Compiler::build() {
     std::cout << "Project: " << config.project_name << std::endl;
     std::cout << "Output: " << getOutputFilePath() << "\n" << std::endl;
     
+    JobScheduler scheduler(config.jobs, trace);
+    scheduler.setMemoryBudget(static_cast<uint64_t>(std::max(config.memory_budget_mb, 0)) * 1024);
+    scheduler.setCancelFlag(cancelFlag);
+    std::vector<size_t> linkJobs;
+    if (!scheduleBuild(scheduler, std::vector<size_t>(), linkJobs)) {
+        return false;
+    }
+    
+    // 并行编译和链接，无论成功与否都保存已完成部分的构建记录
+    bool success = scheduler.run();
+    finishBuild();
+    
+    if (scheduler.wasCancelled()) {
+        std::cout << "\nBuild cancelled" << std::endl;
+        return false;
+    }
+    if (!success) {
+        std::cerr << "\nBuild failed" << std::endl;
+        return false;
+    }
+    
+    std::cout << "\n=== Build Successful ===" << std::endl;
+    std::cout << "Output: " << getOutputFilePath() << std::endl;
+    return true;
+}
+
+bool Compiler::scheduleBuild(JobScheduler& scheduler, const std::vector<size_t>& linkDeps,
+                             std::vector<size_t>& linkJobs) {
     // 创建构建目录
     if (!createBuildDir()) {
         return false;
     }
     
-    // 编译所有源文件
+    // 读取上次构建记录的头文件依赖和编译命令
+    depChecker.openLogs(config.build_dir);
+    
+    // 预编译头在使用它的源文件之前编译
     objectFiles.clear();
-    bool allCompiled = true;
+    scheduledOutputs.clear();
+    TraceSpan checkSpan(trace, "Check dependencies", "deps");
+    std::vector<size_t> pchJobs;
+    bool pchRebuilt = false;
     
-    for (const auto& sourceFile : config.source_files) {
-        std::string objectFile = getObjectFilePath(sourceFile);
-        objectFiles.push_back(objectFile);
+    if (!config.precompiled_header.empty()) {
+        // 包装头文件以绝对路径包含实际的头文件，内容不变时不改写
+        createDirectories(config.build_dir + "/pch");
+        writeFileIfChanged(getPchHeaderPath(),
+                           "#include \"" + absolutePath(config.precompiled_header) + "\"\n");
+        depChecker.invalidateFile(getPchHeaderPath());
         
-        if (!compileSource(sourceFile, objectFile)) {
-            allCompiled = false;
-            break;
+        if (depChecker.needsRecompile(getPchHeaderPath(), getPchOutputPath(), joinArgs(buildPchCommand()))) {
+            Job job;
+            job.description = "Precompiling " + config.precompiled_header + "...";
+            job.run = [this](std::string& output) {
+                bool ok = compilePch(output);
+                depChecker.invalidateFile(getPchOutputPath());
+                return ok;
+            };
+            job.cost = estimateCompileTime(getPchHeaderPath(), getPchOutputPath());
+            job.memory = estimateMemory(getPchOutputPath());
+            pchJobs.push_back(scheduler.addJob(job));
+            scheduledOutputs.push_back(getPchOutputPath());
+            pchRebuilt = true;
+        } else {
+            std::cout << "Skipping " << config.precompiled_header << " (up to date)" << std::endl;
         }
     }
     
-    if (!allCompiled) {
-        std::cerr << "\nBuild failed during compilation" << std::endl;
-        return false;
+    // 先并行读取所有需要检查的文件的信息，之后逐个检查时不再访问文件系统
+    std::vector<std::string> translationUnits = getTranslationUnits();
+    for (const auto& sourceFile : translationUnits) {
+        objectFiles.push_back(getObjectFilePath(sourceFile));
     }
+    depChecker.prefetchFileInfo(translationUnits, objectFiles);
     
-    // 链接
-    if (!linkObjects()) {
-        std::cerr << "\nBuild failed during linking" << std::endl;
-        return false;
+    // 检查依赖，收集需要编译的源文件
+    std::vector<size_t> compileJobs;
+    std::set<std::string> objectDirs;
+    for (const auto& sourceFile : translationUnits) {
+        std::string objectFile = getObjectFilePath(sourceFile);
+        
+        // 预编译头重新生成后，所有源文件都需要重新编译
+        if (!pchRebuilt && !depChecker.needsRecompile(sourceFile, objectFile,
+                                                      joinArgs(buildCompileCommand(sourceFile, objectFile)),
+                                                      getExtraInputs(objectFile))) {
+            std::cout << "Skipping " << sourceFile << " (up to date)" << std::endl;
+            continue;
+        }
+        
+        // 目标文件所在的目录在需要时才创建，每个目录只创建一次
+        std::string objectDir = objectFile.substr(0, objectFile.find_last_of('/'));
+        if (objectDirs.insert(objectDir).second && !createDirectories(objectDir)) {
+            std::cerr << "Error: Failed to create directory: " << objectDir << std::endl;
+            return false;
+        }
+        
+        Job job;
+        job.description = "Compiling " + sourceFile + "...";
+        auto unity = unityMemberCounts.find(sourceFile);
+        if (unity != unityMemberCounts.end()) {
+            job.description = "Compiling " + sourceFile + " (" + std::to_string(unity->second) + " files)...";
+        }
+        job.run = [this, sourceFile, objectFile](std::string& output) {
+            // 目标文件已改写（或被删除），链接检查输入时重新读取其信息
+            bool ok = compileSource(sourceFile, objectFile, output);
+            depChecker.invalidateFile(objectFile);
+            return ok;
+        };
+        job.deps = pchJobs;
+        job.cost = estimateCompileTime(sourceFile, objectFile);
+        job.memory = estimateMemory(objectFile);
+        compileJobs.push_back(scheduler.addJob(job));
+        scheduledOutputs.push_back(objectFile);
     }
     
-    std::cout << "\n=== Build Successful ===" << std::endl;
-    std::cout << "Output: " << getOutputFilePath() << std::endl;
+    checkSpan.end();
+    
+    // 链接在本目标的编译任务和 linkDeps 之后进行；都不需要执行且输入没有变化时跳过
+    std::vector<size_t> deps = compileJobs;
+    deps.insert(deps.end(), linkDeps.begin(), linkDeps.end());
+    std::vector<std::string> linkCommand = buildLinkCommand();
+    std::vector<std::string> linkInputs = getLinkInputs();
+    if (deps.empty() && !depChecker.needsRelink(getOutputFilePath(), joinArgs(linkCommand), linkInputs)) {
+        std::cout << "Skipping " << getOutputFilePath() << " (up to date)" << std::endl;
+        return true;
+    }
+    
+    Job job;
+    job.description = (config.output_type == "static_library" ? "Archiving " : "Linking ") +
+                      getOutputFilePath() + "...";
+    job.run = [this, linkCommand, linkInputs](std::string& output) {
+        // 依赖本目标的其他目标随后检查链接输入时读取新的信息
+        bool ok = linkObjects(linkCommand, linkInputs, output);
+        depChecker.invalidateFile(getOutputFilePath());
+        return ok;
+    };
+    job.deps = deps;
+    job.cost = estimateLinkTime(linkInputs);
+    job.memory = estimateMemory(getOutputFilePath());
+    linkJobs.push_back(scheduler.addJob(job));
     return true;
 }
 
+void Compiler::finishBuild() {
+    depChecker.closeLogs();
+    for (const auto& output : scheduledOutputs) {
+        depChecker.invalidateFile(output);
+    }
+    
+    if (objectCache.enabled() && objectCache.hits() + objectCache.misses() > 0) {
+        std::cout << "Cache: " << objectCache.hits() << " hits, "
+                  << objectCache.misses() << " misses" << std::endl;
+        objectCache.trim();
+    }
+}
+
+void Compiler::setCancelFlag(const std::atomic<bool>* cancel) {
+    cancelFlag = cancel;
+}
+
+void Compiler::setFileSnapshot(FileSnapshot* snapshot) {
+    depChecker.setSnapshot(snapshot);
+}
+
+void Compiler::invalidateFiles(const std::vector<std::string>& files) {
+    for (const auto& file : files) {
+        depChecker.invalidateFile(file);
+    }
+}
+
+std::vector<std::string> Compiler::getInputFiles() {
+    std::set<std::string> inputs(config.source_files.begin(), config.source_files.end());
+    if (!config.precompiled_header.empty()) {
+        inputs.insert(config.precompiled_header);
+        std::vector<std::string> deps;
+        if (depChecker.getDeps(getPchOutputPath(), deps)) {
+            inputs.insert(deps.begin(), deps.end());
+        }
+    }
+    
+    // 上次编译记录的头文件依赖；构建目录中生成的文件（合并源文件、预编译头包装）除外
+    std::string buildPrefix = config.build_dir + "/";
+    for (const auto& objectFile : objectFiles) {
+        std::vector<std::string> deps;
+        if (depChecker.getDeps(objectFile, deps)) {
+            inputs.insert(deps.begin(), deps.end());
+        }
+    }
+    std::vector<std::string> result;
+    for (const auto& input : inputs) {
+        if (input.compare(0, buildPrefix.size(), buildPrefix) != 0) {
+            result.push_back(input);
+        }
+    }
+    return result;
+}
+
 bool Compiler::clean() {
     std::cout << "Cleaning build directory..." << std::endl;
     
-#ifdef _WIN32
-    std::string command = "rmdir /s /q " + config.build_dir;
-#else
-    std::string command = "rm -rf " + config.build_dir;
-#endif
-    
     if (depChecker.fileExists(config.build_dir)) {
-        system(command.c_str());
+        if (!removeAll(config.build_dir)) {
+            std::cerr << "Error: Failed to remove " << config.build_dir << std::endl;
+            return false;
+        }
         std::cout << "Clean complete" << std::endl;
     } else {
         std::cout << "Build directory does not exist" << std::endl;
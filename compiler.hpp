@@ -3,50 +3,184 @@
 
 #include "config.hpp"
 #include "dependency.hpp"
+#include "scheduler.hpp"
+#include "cache.hpp"
+#include "remote.hpp"
 #include <string>
 #include <vector>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
 
 class Compiler {
 public:
-    Compiler(const BuildConfig& config);
+    // trace 不为空时记录依赖检查、每个编译任务和链接的耗时
+    Compiler(const BuildConfig& config, BuildTrace* trace = nullptr);
     
     // 执行完整的构建流程
     bool build();
     
+    // 把构建任务（预编译头、编译、链接）加入调度器，链接任务在 linkDeps 完成后才开始
+    // linkJobs 返回链接任务的编号；没有需要执行的任务时链接被跳过，linkJobs 为空
+    bool scheduleBuild(JobScheduler& scheduler, const std::vector<size_t>& linkDeps,
+                       std::vector<size_t>& linkJobs);
+    
+    // 调度器运行结束后保存构建记录
+    void finishBuild();
+    
+    // 增加链接输入（如同一项目中其他目标生成的库），变化时重新链接
+    void addLinkInput(const std::string& file);
+    
+    // 获取输出文件路径
+    std::string getOutputFilePath();
+    
     // 清理构建文件
     bool clean();
     
     // 重新构建（清理后构建）
     bool rebuild();
     
+    // cancel 被设置为 true 后不再启动新的编译任务，build() 返回 false
+    void setCancelFlag(const std::atomic<bool>* cancel);
+    
+    // 与同一项目中的其他目标共用文件信息快照，共同的头文件只读取一次
+    void setFileSnapshot(FileSnapshot* snapshot);
+    
+    // 这些文件发生了变化，下次构建时重新读取其信息
+    void invalidateFiles(const std::vector<std::string>& files);
+    
+    // 构建的所有输入文件：源文件、预编译头和上次构建记录的头文件依赖
+    std::vector<std::string> getInputFiles();
+    
 private:
     BuildConfig config;
+    BuildTrace* trace;
+    const std::atomic<bool>* cancelFlag;
     DependencyChecker depChecker;
+    ObjectCache objectCache;
+    RemoteWorkers remoteWorkers;
     std::vector<std::string> objectFiles;
+    std::vector<std::string> extraLinkInputs;
+    std::vector<std::string> scheduledOutputs;
+    std::map<std::string, size_t> unityMemberCounts;
+    std::once_flag compilerIdentityOnce;
+    uint64_t compilerIdentity;
+    std::string linkerName;
+    std::string linkerSearchDir; // 通过 -B 使用链接器时的目录（GCC 使用 mold），此时不加 -fuse-ld
+    bool linkerResolved;
     
     // 创建构建目录
     bool createBuildDir();
     
-    // 编译单个源文件
-    bool compileSource(const std::string& sourceFile, const std::string& objectFile);
+    // 获取要编译的源文件列表；启用合并编译时生成合并后的源文件
+    std::vector<std::string> getTranslationUnits();
     
-    // 链接所有目标文件
-    bool linkObjects();
+    // 任务的预计耗时（毫秒）：使用上次记录的耗时，没有记录时按源文件大小和 #include 数量
+    // （链接按输入文件数）估计，用于按关键路径调度
+    uint64_t estimateCompileTime(const std::string& sourceFile, const std::string& objectFile);
+    uint64_t estimateLinkTime(const std::vector<std::string>& inputs);
+    
+    // 生成输出文件时编译器或链接器的预计峰值内存（KB）：使用上次记录的值，没有记录时为固定的估计值，
+    // 用于按内存预算限制同时运行的任务
+    uint64_t estimateMemory(const std::string& outputFile);
+    
+    // 编译预编译头，编译器输出写入 output
+    bool compilePch(std::string& output);
+    
+    // 编译单个源文件，编译器输出写入 output
+    bool compileSource(const std::string& sourceFile, const std::string& objectFile, std::string& output);
+    
+    // 链接所有目标文件，输入没有变化时跳过；链接器输出写入 output
+    bool linkObjects(const std::vector<std::string>& command,
+                     const std::vector<std::string>& inputs, std::string& output);
+    
+    // 生成静态库：已有的静态库中只替换发生变化的成员
+    bool archiveObjects(const std::vector<std::string>& command,
+                        const std::vector<std::string>& objects, std::string& output);
+    
+    // 构建编译和预处理共用的编译器和编译选项
+    std::vector<std::string> buildCompileFlags();
     
     // 构建编译命令
-    std::string buildCompileCommand(const std::string& sourceFile, const std::string& objectFile);
+    std::vector<std::string> buildCompileCommand(const std::string& sourceFile, const std::string& objectFile);
+    
+    // 构建预编译头的编译命令
+    std::vector<std::string> buildPchCommand();
+    
+    // 构建预处理命令
+    std::vector<std::string> buildPreprocessCommand(const std::string& sourceFile, const std::string& outputFile);
+    
+    // 在工作进程上编译预处理结果使用的编译器和选项：去掉启动器（如 ccache）、编译器的目录
+    // 和只影响预处理的选项（-I、-D、-include 等）
+    std::vector<std::string> buildRemoteCompileFlags();
     
-    // 构建链接命令
-    std::string buildLinkCommand();
+    // 预处理源文件，同时生成目标文件的依赖文件（供缓存和分布式编译使用）
+    bool preprocessSource(const std::string& sourceFile, const std::string& objectFile,
+                          const std::string& preprocessed);
     
-    // 执行系统命令
-    bool executeCommand(const std::string& command);
+    // 计算编译缓存的键：预处理结果 + 编译命令 + 编译器版本
+    bool computeCacheKey(const std::string& sourceFile, const std::string& preprocessed, uint64_t& key);
     
-    // 获取目标文件路径
+    // 把预处理结果发送到工作进程编译，成功时写入目标文件；失败时由调用者在本机编译
+    bool compileRemote(const std::string& sourceFile, const std::string& objectFile,
+                       const std::string& preprocessed, std::string& output);
+    
+    // 编译器版本信息的哈希（只在第一次需要时执行一次）
+    uint64_t getCompilerIdentity();
+    
+    // 构建链接命令（静态库为归档所有目标文件的命令）
+    std::vector<std::string> buildLinkCommand();
+    
+    // 构建把 members 加入（或替换到）静态库中的 ar 命令
+    std::vector<std::string> buildArchiveCommand(const std::vector<std::string>& members);
+    
+    // 链接时优化的链接选项：按并行任务数分区，ThinLTO 使用构建目录中的缓存
+    std::vector<std::string> buildLtoLinkFlags(const std::string& linker);
+    
+    // 生成静态库的工具：使用 LTO 时为 gcc-ar 或 llvm-ar
+    std::string getArchiver();
+    
+    // 实际使用的链接器（"auto" 时在 PATH 中查找 mold 和 lld），为空表示编译器默认的链接器
+    // GCC 12.1 之前不支持 -fuse-ld=mold，"auto" 为 GCC 选择 mold 时改用 -B 指向 mold 安装的 ld
+    std::string getLinker();
+    
+    // 是否使用分离的调试信息（.dwo）
+    bool useSplitDwarf();
+    
+    // 把所有 .dwo 文件打包为 <输出文件>.dwp
+    bool packageDebugInfo(std::string& output);
+    
+    // 链接的输入文件：所有目标文件、其他目标生成的库和在 library_dirs 中找到的库文件
+    // （静态库只有目标文件）
+    std::vector<std::string> getLinkInputs();
+    
+    // 直接启动命令（不经过 shell），捕获其标准输出和错误输出
+    // 命令行过长时使用 responseFile 作为响应文件；peakMemoryKb 不为空时写入进程的峰值内存
+    bool executeCommand(const std::vector<std::string>& command, std::string& output,
+                        const std::string& responseFile = "", uint64_t* peakMemoryKb = nullptr);
+    
+    // 获取目标文件路径：build_dir/obj/ 下与源文件相同的相对路径加上 .o
     std::string getObjectFilePath(const std::string& sourceFile);
     
-    // 获取输出文件路径
-    std::string getOutputFilePath();
+    // 获取依赖文件路径（与目标文件同名的 .d 文件）
+    std::string getDepFilePath(const std::string& objectFile);
+    
+    // 预编译头在构建目录中的包装头文件路径（-include 的参数）
+    std::string getPchHeaderPath();
+    
+    // 预编译头的输出路径（.gch 或 .pch）
+    std::string getPchOutputPath();
+    
+    // 源文件的依赖文件中不会列出的其他输入（如预编译头、PGO 训练数据）
+    std::vector<std::string> getExtraInputs(const std::string& objectFile);
+    
+    // 编译目标文件使用的 PGO 训练数据（clang 为合并后的 .profdata，GCC 为目标文件旁的 .gcda），
+    // 插桩构建、没有配置 pgo 或还没有训练数据时为空
+    std::string getProfileDataPath(const std::string& objectFile);
+    
+    // 编译器是否为 clang
+    bool isClang();
 };
 
 #endif // COMPILER_HPP
@@ -1,158 +1,414 @@
 #include "config.hpp"
+#include "trace.hpp"
+#include "json.hpp"
+#include "glob.hpp"
+#include "process.hpp"
+#include "scheduler.hpp"
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <algorithm>
+#include <climits>
+#include <set>
+#include <cstdlib>
 
 #ifdef _WIN32
-#include <windows.h>
 #include <sys/stat.h>
 #else
-#include <dirent.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
 #endif
 
-ConfigParser::ConfigParser() {
+ConfigParser::ConfigParser(BuildTrace* trace) : trace(trace), dirCacheLoaded(false) {
     // 设置默认值
     config.cpp_standard = "c++17";
     config.optimization = "O2";
+    config.lto = "off";
     config.debug = false;
+    config.jobs = 0;
+    config.memory_budget_mb = 0;
+    config.dirty_check = "mtime";
+    config.cache_max_size_mb = 5120;
+    config.unity_batch_size = 0;
+    config.linker = "auto";
+    config.split_dwarf = false;
+    config.dwp = false;
+    config.compress_debug_sections = false;
+    config.thin_archive = false;
+    config.pgo_instrument = false;
     config.build_dir = "build";
     config.compiler = "g++";
     config.output_type = "executable";
 }
 
 bool ConfigParser::loadFromFile(const std::string& filename) {
-    std::ifstream file(filename);
+    TraceSpan span(trace, "Parse " + filename, "config");
+    configFile = filename;
+    
+    // 一次读入整个文件（POSIX 上直接映射），解析器只顺序扫描一遍
+    const char* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    std::ifstream file(filename, std::ios::binary);
     if (!file.is_open()) {
         std::cerr << "Error: Cannot open config file: " << filename << std::endl;
         return false;
     }
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    data = content.data();
+    size = content.size();
+#else
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Error: Cannot open config file: " << filename << std::endl;
+        return false;
+    }
+    struct stat info;
+    void* mapping = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        size = static_cast<size_t>(info.st_size);
+        mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            close(fd);
+            std::cerr << "Error: Cannot read config file: " << filename << std::endl;
+            return false;
+        }
+        data = static_cast<const char*>(mapping);
+    }
+    close(fd);
+#endif
     
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    std::string content = buffer.str();
-    file.close();
+    JsonValue root;
+    JsonParser parser(data, size);
+    bool parsed = parser.parse(root);
+#ifndef _WIN32
+    if (mapping != MAP_FAILED) {
+        munmap(mapping, size);
+    }
+#endif
+    if (!parsed) {
+        std::cerr << "Error: " << filename << ":" << parser.error() << std::endl;
+        return false;
+    }
+    
+    if (!parseConfig(root)) {
+        return false;
+    }
     
-    return parseJson(content);
+    // 构建目录在第一次构建时创建，之后的构建才能使用目录列表缓存
+    if (dirCacheLoaded && isDirectory(config.build_dir)) {
+        dirCache.save();
+    }
+    return true;
 }
 
-std::string ConfigParser::trim(const std::string& str) {
-    size_t first = str.find_first_not_of(" \t\n\r\"");
-    if (first == std::string::npos) return "";
-    size_t last = str.find_last_not_of(" \t\n\r\",\"");
-    return str.substr(first, last - first + 1);
+bool ConfigParser::reportError(const JsonValue& value, const std::string& message) {
+    std::cerr << "Error: " << configFile << ":" << value.line() << ":" << value.column() << ": "
+              << message << std::endl;
+    return false;
 }
 
-std::string ConfigParser::extractString(const std::string& json, const std::string& key) {
-    std::string searchKey = "\"" + key + "\"";
-    size_t pos = json.find(searchKey);
-    if (pos == std::string::npos) return "";
-    
-    pos = json.find(":", pos);
-    if (pos == std::string::npos) return "";
-    
-    size_t start = json.find("\"", pos);
-    if (start == std::string::npos) return "";
-    start++;
-    
-    size_t end = json.find("\"", start);
-    if (end == std::string::npos) return "";
-    
-    return json.substr(start, end - start);
+bool ConfigParser::readString(const JsonValue& object, const char* key, std::string& value) {
+    const JsonValue* field = object.find(key);
+    if (!field) {
+        return true;
+    }
+    if (!field->isString()) {
+        return reportError(*field, std::string(key) + " must be a string, not " +
+                           JsonValue::typeName(field->type()));
+    }
+    value = field->asString();
+    return true;
 }
 
-std::vector<std::string> ConfigParser::extractArray(const std::string& json, const std::string& key) {
-    std::vector<std::string> result;
-    std::string searchKey = "\"" + key + "\"";
-    size_t pos = json.find(searchKey);
-    if (pos == std::string::npos) return result;
-    
-    pos = json.find("[", pos);
-    if (pos == std::string::npos) return result;
-    
-    size_t end = json.find("]", pos);
-    if (end == std::string::npos) return result;
-    
-    std::string arrayContent = json.substr(pos + 1, end - pos - 1);
-    
-    size_t start = 0;
-    while (true) {
-        size_t quoteStart = arrayContent.find("\"", start);
-        if (quoteStart == std::string::npos) break;
-        
-        size_t quoteEnd = arrayContent.find("\"", quoteStart + 1);
-        if (quoteEnd == std::string::npos) break;
-        
-        std::string item = arrayContent.substr(quoteStart + 1, quoteEnd - quoteStart - 1);
-        if (!item.empty()) {
-            result.push_back(item);
+bool ConfigParser::readBool(const JsonValue& object, const char* key, bool& value) {
+    const JsonValue* field = object.find(key);
+    if (!field) {
+        return true;
+    }
+    if (!field->isBool()) {
+        return reportError(*field, std::string(key) + " must be true or false, not " +
+                           JsonValue::typeName(field->type()));
+    }
+    value = field->asBool();
+    return true;
+}
+
+bool ConfigParser::readInt(const JsonValue& object, const char* key, int& value) {
+    const JsonValue* field = object.find(key);
+    if (!field) {
+        return true;
+    }
+    // 先检查范围，超出 int 范围的浮点数转换为 int 是未定义行为
+    double number = field->asNumber();
+    if (!field->isNumber() || !(number >= INT_MIN && number <= INT_MAX) ||
+        number != static_cast<double>(static_cast<int>(number))) {
+        return reportError(*field, std::string(key) + " must be an integer");
+    }
+    value = static_cast<int>(number);
+    return true;
+}
+
+bool ConfigParser::readStringArray(const JsonValue& object, const char* key, std::vector<std::string>& values) {
+    const JsonValue* field = object.find(key);
+    if (!field) {
+        return true;
+    }
+    if (!field->isArray()) {
+        return reportError(*field, std::string(key) + " must be an array of strings, not " +
+                           JsonValue::typeName(field->type()));
+    }
+    values.clear();
+    values.reserve(field->items().size());
+    for (const auto& item : field->items()) {
+        if (!item.isString()) {
+            return reportError(item, std::string("Elements of ") + key + " must be strings, not " +
+                               JsonValue::typeName(item.type()));
+        }
+        if (!item.asString().empty()) {
+            values.push_back(item.asString());
         }
-        
-        start = quoteEnd + 1;
     }
-    
-    return result;
+    return true;
 }
 
-bool ConfigParser::extractBool(const std::string& json, const std::string& key, bool defaultValue) {
-    std::string searchKey = "\"" + key + "\"";
-    size_t pos = json.find(searchKey);
-    if (pos == std::string::npos) return defaultValue;
-    
-    pos = json.find(":", pos);
-    if (pos == std::string::npos) return defaultValue;
-    
-    size_t truePos = json.find("true", pos);
-    size_t falsePos = json.find("false", pos);
-    size_t nextKey = json.find("\"", pos + 1);
-    
-    if (truePos != std::string::npos && (nextKey == std::string::npos || truePos < nextKey)) {
+bool ConfigParser::readUnityBuild(const JsonValue& object, BuildConfig& target) {
+    const JsonValue* unityBuild = object.find("unity_build");
+    if (!unityBuild) {
+        return true;
+    }
+    if (!unityBuild->isObject()) {
+        return reportError(*unityBuild, "unity_build must be an object");
+    }
+    target.unity_batch_size = 8;
+    target.unity_exclude.clear();
+    return readInt(*unityBuild, "batch_size", target.unity_batch_size) &&
+           readStringArray(*unityBuild, "exclude", target.unity_exclude);
+}
+
+bool ConfigParser::readPgo(const JsonValue& object, BuildConfig& target) {
+    const JsonValue* pgo = object.find("pgo");
+    if (!pgo) {
         return true;
     }
-    if (falsePos != std::string::npos && (nextKey == std::string::npos || falsePos < nextKey)) {
+    if (!pgo->isObject()) {
+        return reportError(*pgo, "pgo must be an object");
+    }
+    target.pgo_train.clear();
+    if (!readStringArray(*pgo, "train", target.pgo_train)) {
         return false;
     }
-    
-    return defaultValue;
+    if (target.pgo_train.empty()) {
+        return reportError(*pgo, "pgo requires a train command");
+    }
+    return true;
 }
 
-bool ConfigParser::parseJson(const std::string& content) {
-    // 简单的JSON解析（针对我们的配置格式）
-    config.project_name = extractString(content, "project_name");
-    config.output_name = extractString(content, "output_name");
-    config.output_type = extractString(content, "output_type");
-    config.cpp_standard = extractString(content, "cpp_standard");
-    config.optimization = extractString(content, "optimization");
-    config.debug = extractBool(content, "debug", false);
-    config.build_dir = extractString(content, "build_dir");
-    config.compiler = extractString(content, "compiler");
+static bool isValidOutputType(const std::string& outputType) {
+    if (outputType != "executable" && outputType != "library" && outputType != "static_library") {
+        std::cerr << "Error: output_type must be \"executable\", \"library\" or \"static_library\"" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static bool isValidLto(const std::string& lto) {
+    if (lto != "off" && lto != "full" && lto != "thin") {
+        std::cerr << "Error: lto must be \"off\", \"full\" or \"thin\"" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool ConfigParser::parseConfig(const JsonValue& root) {
+    if (!root.isObject()) {
+        return reportError(root, "The configuration must be a JSON object");
+    }
+    
+    std::vector<std::string> rawSourceFiles;
+    bool valid = readString(root, "project_name", config.project_name) &&
+                 readString(root, "output_name", config.output_name) &&
+                 readString(root, "output_type", config.output_type) &&
+                 readString(root, "cpp_standard", config.cpp_standard) &&
+                 readString(root, "optimization", config.optimization) &&
+                 readString(root, "lto", config.lto) &&
+                 readBool(root, "debug", config.debug) &&
+                 readInt(root, "jobs", config.jobs) &&
+                 readInt(root, "memory_budget_mb", config.memory_budget_mb) &&
+                 readString(root, "build_dir", config.build_dir) &&
+                 readString(root, "compiler", config.compiler) &&
+                 readString(root, "dirty_check", config.dirty_check) &&
+                 readString(root, "cache_dir", config.cache_dir) &&
+                 readString(root, "precompiled_header", config.precompiled_header) &&
+                 readInt(root, "cache_max_size_mb", config.cache_max_size_mb) &&
+                 readString(root, "linker", config.linker) &&
+                 readBool(root, "split_dwarf", config.split_dwarf) &&
+                 readBool(root, "dwp", config.dwp) &&
+                 readBool(root, "compress_debug_sections", config.compress_debug_sections) &&
+                 readBool(root, "thin_archive", config.thin_archive) &&
+                 readStringArray(root, "source_files", rawSourceFiles) &&
+                 readStringArray(root, "include_dirs", config.include_dirs) &&
+                 readStringArray(root, "library_dirs", config.library_dirs) &&
+                 readStringArray(root, "libraries", config.libraries) &&
+                 readStringArray(root, "compile_flags", config.compile_flags) &&
+                 readStringArray(root, "link_flags", config.link_flags) &&
+                 readStringArray(root, "workers", config.workers) &&
+                 readUnityBuild(root, config) &&
+                 readPgo(root, config);
+    if (!valid) {
+        return false;
+    }
     
     // 如果某些字段为空，使用默认值
     if (config.cpp_standard.empty()) config.cpp_standard = "c++17";
     if (config.optimization.empty()) config.optimization = "O2";
+    if (config.lto.empty()) config.lto = "off";
     if (config.build_dir.empty()) config.build_dir = "build";
     if (config.compiler.empty()) config.compiler = "g++";
     if (config.output_type.empty()) config.output_type = "executable";
+    if (config.dirty_check.empty()) config.dirty_check = "mtime";
+    if (config.linker.empty()) config.linker = "auto";
+    if (!config.pgo_train.empty()) config.pgo_dir = config.build_dir + "/pgo";
+    
+    // 有工作进程时默认并行数包括工作进程：编译任务大多在其他机器上运行
+    if (config.jobs == 0 && !config.workers.empty()) {
+        config.jobs = JobScheduler::defaultJobCount() * static_cast<int>(1 + config.workers.size());
+    }
     
-    std::vector<std::string> rawSourceFiles = extractArray(content, "source_files");
     config.source_files = expandSourceFiles(rawSourceFiles);
-    config.include_dirs = extractArray(content, "include_dirs");
-    config.library_dirs = extractArray(content, "library_dirs");
-    config.libraries = extractArray(content, "libraries");
-    config.compile_flags = extractArray(content, "compile_flags");
-    config.link_flags = extractArray(content, "link_flags");
+    
+    const JsonValue* targets = root.find("targets");
+    if (targets && !targets->isArray()) {
+        return reportError(*targets, "targets must be an array of objects");
+    }
     
     if (config.project_name.empty()) {
         std::cerr << "Error: project_name is required in config file" << std::endl;
         return false;
     }
     
-    if (config.source_files.empty()) {
+    if (config.source_files.empty() && (!targets || targets->items().empty())) {
         std::cerr << "Error: source_files is required in config file" << std::endl;
         return false;
     }
     
+    if (!isValidOutputType(config.output_type) || !isValidLto(config.lto)) {
+        return false;
+    }
+    
+    if (config.dirty_check != "mtime" && config.dirty_check != "hash") {
+        std::cerr << "Error: dirty_check must be \"mtime\" or \"hash\"" << std::endl;
+        return false;
+    }
+    
+    if (config.linker != "auto" && config.linker != "default" && config.linker != "bfd" &&
+        config.linker != "gold" && config.linker != "lld" && config.linker != "mold") {
+        std::cerr << "Error: linker must be \"auto\", \"default\", \"bfd\", \"gold\", \"lld\" or \"mold\"" << std::endl;
+        return false;
+    }
+    
+    if (config.dwp && !config.split_dwarf) {
+        std::cerr << "Warning: dwp has no effect without split_dwarf" << std::endl;
+    }
+    
+    // 多目标：每个目标在顶层配置的基础上覆盖或追加设置
+    std::map<std::string, size_t> targetIndex;
+    for (size_t i = 0; targets && i < targets->items().size(); i++) {
+        const JsonValue& object = targets->items()[i];
+        if (!object.isObject()) {
+            return reportError(object, "Elements of targets must be objects");
+        }
+        BuildConfig target;
+        if (!parseTarget(object, target)) {
+            return false;
+        }
+        if (targetIndex.count(target.target_name)) {
+            std::cerr << "Error: Duplicate target name: " << target.target_name << std::endl;
+            return false;
+        }
+        targetIndex[target.target_name] = config.targets.size();
+        config.targets.push_back(target);
+    }
+    for (const auto& target : config.targets) {
+        for (const auto& dep : target.target_deps) {
+            if (!targetIndex.count(dep)) {
+                std::cerr << "Error: Target " << target.target_name << " depends on unknown target: "
+                          << dep << std::endl;
+                return false;
+            }
+        }
+    }
+    
+    return true;
+}
+
+static void appendUnique(std::vector<std::string>& values, const std::vector<std::string>& extra) {
+    for (const auto& value : extra) {
+        if (std::find(values.begin(), values.end(), value) == values.end()) {
+            values.push_back(value);
+        }
+    }
+}
+
+bool ConfigParser::parseTarget(const JsonValue& object, BuildConfig& target) {
+    // 目标继承顶层的所有设置，字符串等字段可以覆盖，数组字段在顶层的基础上追加；
+    // 不复制已解析的目标，否则每个目标都嵌套之前所有目标的副本
+    std::vector<BuildConfig> parsedTargets;
+    parsedTargets.swap(config.targets);
+    target = config;
+    parsedTargets.swap(config.targets);
+    target.source_files.clear();
+    target.target_name.clear();
+    if (!readString(object, "name", target.target_name)) {
+        return false;
+    }
+    if (target.target_name.empty()) {
+        return reportError(object, "Every entry in targets requires a name");
+    }
+    target.output_name = target.target_name;
+    target.output_type = "executable";
+    
+    std::vector<std::string> rawSourceFiles, includeDirs, libraryDirs, libraries, compileFlags, linkFlags;
+    bool valid = readString(object, "output_name", target.output_name) &&
+                 readString(object, "output_type", target.output_type) &&
+                 readString(object, "cpp_standard", target.cpp_standard) &&
+                 readString(object, "optimization", target.optimization) &&
+                 readString(object, "lto", target.lto) &&
+                 readString(object, "precompiled_header", target.precompiled_header) &&
+                 readBool(object, "debug", target.debug) &&
+                 readBool(object, "thin_archive", target.thin_archive) &&
+                 readStringArray(object, "source_files", rawSourceFiles) &&
+                 readStringArray(object, "include_dirs", includeDirs) &&
+                 readStringArray(object, "library_dirs", libraryDirs) &&
+                 readStringArray(object, "libraries", libraries) &&
+                 readStringArray(object, "compile_flags", compileFlags) &&
+                 readStringArray(object, "link_flags", linkFlags) &&
+                 readStringArray(object, "deps", target.target_deps) &&
+                 readUnityBuild(object, target);
+    if (!valid) {
+        return false;
+    }
+    if (target.output_name.empty()) target.output_name = target.target_name;
+    if (target.output_type.empty()) target.output_type = "executable";
+    if (target.cpp_standard.empty()) target.cpp_standard = config.cpp_standard;
+    if (target.optimization.empty()) target.optimization = config.optimization;
+    if (target.lto.empty()) target.lto = config.lto;
+    if (!isValidOutputType(target.output_type) || !isValidLto(target.lto)) {
+        return false;
+    }
+    
+    target.source_files = expandSourceFiles(rawSourceFiles);
+    appendUnique(target.include_dirs, includeDirs);
+    appendUnique(target.library_dirs, libraryDirs);
+    appendUnique(target.libraries, libraries);
+    appendUnique(target.compile_flags, compileFlags);
+    appendUnique(target.link_flags, linkFlags);
+    
+    if (target.source_files.empty()) {
+        return reportError(object, "Target " + target.target_name + " has no source_files");
+    }
     return true;
 }
 
@@ -164,8 +420,54 @@ void ConfigParser::printConfig() const {
     std::cout << "Compiler: " << config.compiler << std::endl;
     std::cout << "C++ Standard: " << config.cpp_standard << std::endl;
     std::cout << "Optimization: " << config.optimization << std::endl;
-    std::cout << "Debug: " << (config.debug ? "Yes" : "No") << std::endl;
+    if (config.lto != "off") {
+        std::cout << "LTO: " << config.lto << std::endl;
+    }
+    std::cout << "Debug: " << (config.debug ? "Yes" : "No");
+    if (config.debug && config.split_dwarf) {
+        std::cout << (config.dwp ? " (split DWARF, .dwp)" : " (split DWARF)");
+    }
+    if (config.debug && config.compress_debug_sections) {
+        std::cout << " (compressed)";
+    }
+    std::cout << std::endl;
+    std::cout << "Linker: " << config.linker << std::endl;
+    if (config.output_type == "static_library" && config.thin_archive) {
+        std::cout << "Thin Archive: Yes" << std::endl;
+    }
+    std::cout << "Jobs: " << (config.jobs > 0 ? std::to_string(config.jobs) : "auto") << std::endl;
+    if (config.memory_budget_mb > 0) {
+        std::cout << "Memory Budget: " << config.memory_budget_mb << " MB" << std::endl;
+    }
+    std::cout << "Dirty Check: " << config.dirty_check << std::endl;
+    if (!config.cache_dir.empty()) {
+        std::cout << "Cache Dir: " << config.cache_dir << " (max " << config.cache_max_size_mb << " MB)" << std::endl;
+    }
     std::cout << "Build Dir: " << config.build_dir << std::endl;
+    if (!config.precompiled_header.empty()) {
+        std::cout << "Precompiled Header: " << config.precompiled_header << std::endl;
+    }
+    if (config.unity_batch_size > 0) {
+        std::cout << "Unity Build: " << config.unity_batch_size << " files per batch" << std::endl;
+    }
+    if (!config.pgo_train.empty()) {
+        std::cout << "PGO Training: " << joinArgs(config.pgo_train) << std::endl;
+    }
+    if (!config.workers.empty()) {
+        std::cout << "Workers: " << joinArgs(config.workers) << std::endl;
+    }
+    
+    if (!config.targets.empty()) {
+        std::cout << "\nTargets (" << config.targets.size() << "):" << std::endl;
+        for (const auto& target : config.targets) {
+            std::cout << "  - " << target.target_name << " (" << target.output_type << ", "
+                      << target.source_files.size() << " files)";
+            for (size_t i = 0; i < target.target_deps.size(); i++) {
+                std::cout << (i == 0 ? " <- " : ", ") << target.target_deps[i];
+            }
+            std::cout << std::endl;
+        }
+    }
     
     std::cout << "\nSource Files (" << config.source_files.size() << "):" << std::endl;
     for (const auto& file : config.source_files) {
@@ -261,17 +563,33 @@ bool ConfigParser::generateGuideDocument(const std::string& filename) {
     file << "| Field | Type | Default | Description |\n";
     file << "|-------|------|---------|-------------|\n";
     file << "| `output_name` | string | `project_name` | Name of the output executable/library |\n";
-    file << "| `output_type` | string | `\"executable\"` | Output type: `\"executable\"` or `\"library\"` |\n";
+    file << "| `output_type` | string | `\"executable\"` | Output type: `\"executable\"`, `\"library\"` or `\"static_library\"` |\n";
     file << "| `compiler` | string | `\"g++\"` | Compiler to use: `\"g++\"` or `\"gcc\"` |\n";
     file << "| `cpp_standard` | string | `\"c++17\"` | C++ standard version |\n";
     file << "| `optimization` | string | `\"O2\"` | Optimization level |\n";
+    file << "| `lto` | string | `\"off\"` | Link-time optimization: `\"off\"`, `\"full\"` or `\"thin\"` |\n";
     file << "| `debug` | boolean | `false` | Include debug symbols |\n";
-    file << "| `build_dir` | string | `\"build\"` | Directory for build artifacts |\n";
+    file << "| `linker` | string | `\"auto\"` | Linker: `\"auto\"`, `\"default\"`, `\"bfd\"`, `\"gold\"`, `\"lld\"` or `\"mold\"` |\n";
+    file << "| `split_dwarf` | boolean | `false` | Write debug info to separate `.dwo` files (with `debug`) |\n";
+    file << "| `dwp` | boolean | `false` | Package `.dwo` files into `<output>.dwp` after linking |\n";
+    file << "| `compress_debug_sections` | boolean | `false` | Compress debug sections (`-gz`) |\n";
+    file << "| `thin_archive` | boolean | `false` | Create static libraries as thin archives |\n";
+    file << "| `build_dir` | string | `\"build\"` | Directory for build artifacts; objects mirror the source tree under `obj/` |\n";
+    file << "| `jobs` | number | `0` | Parallel compile jobs (`0` = number of CPU cores, fewer when memory is low) |\n";
+    file << "| `memory_budget_mb` | number | `0` | Memory limit for jobs running at the same time (`0` = available memory) |\n";
+    file << "| `dirty_check` | string | `\"mtime\"` | How changed inputs are detected: `\"mtime\"` or `\"hash\"` |\n";
+    file << "| `precompiled_header` | string | `\"\"` | Header precompiled once and included in every source |\n";
+    file << "| `unity_build` | object | none | Compile sources in merged batches: `{ \"batch_size\": N, \"exclude\": [...] }` |\n";
+    file << "| `pgo` | object | none | Training command for `buildpp pgo`: `{ \"train\": [...] }` |\n";
+    file << "| `workers` | array | `[]` | `buildpp worker` addresses for distributed compilation |\n";
+    file << "| `cache_dir` | string | `\"\"` | Compilation cache directory (empty = disabled) |\n";
+    file << "| `cache_max_size_mb` | number | `5120` | Size limit of the compilation cache in MB |\n";
     file << "| `include_dirs` | array | `[]` | Header file search paths |\n";
     file << "| `library_dirs` | array | `[]` | Library search paths |\n";
     file << "| `libraries` | array | `[]` | Libraries to link against |\n";
     file << "| `compile_flags` | array | `[]` | Additional compiler flags |\n";
     file << "| `link_flags` | array | `[]` | Additional linker flags |\n\n";
+    file << "| `targets` | array | none | Several libraries and executables built together (see below) |\n";
     
     file << "## Field Details\n\n";
     
@@ -295,8 +613,8 @@ bool ConfigParser::generateGuideDocument(const std::string& filename) {
     file << "### output_type\n";
     file << "**Type:** string (optional)  \n";
     file << "**Default:** `\"executable\"`  \n";
-    file << "**Options:** `\"executable\"` or `\"library\"`  \n";
-    file << "**Description:** Type of output to generate.\n\n";
+    file << "**Options:** `\"executable\"`, `\"library\"` (shared, `lib<name>.so`) or `\"static_library\"` (`lib<name>.a`)  \n";
+    file << "**Description:** Type of output to generate. Static libraries are created with `ar`; when some objects change, only those members are replaced in the existing archive instead of writing it again from scratch.\n\n";
     
     file << "### compiler\n";
     file << "**Type:** string (optional)  \n";
@@ -320,28 +638,145 @@ bool ConfigParser::generateGuideDocument(const std::string& filename) {
     file << "- `\"O3\"` - Aggressive optimization\n";
     file << "- `\"Os\"` - Optimize for size\n\n";
     
+    file << "### lto\n";
+    file << "**Type:** string (optional)  \n";
+    file << "**Default:** `\"off\"`  \n";
+    file << "**Options:**\n";
+    file << "- `\"off\"` - No link-time optimization\n";
+    file << "- `\"full\"` - Optimize the whole program as one module at link time (`-flto`)\n";
+    file << "- `\"thin\"` - ThinLTO with clang (`-flto=thin`): modules are optimized in parallel and cached in `build_dir/lto-cache`, so a relink after a small change only redoes the changed modules. GCC has no ThinLTO; it uses its partitioned LTO as for `\"full\"`\n\n";
+    file << "**Description:** The same setting is passed to every compile and to the link. LTO code generation at link time runs `jobs` partitions in parallel (`-flto=N` for GCC, `--thinlto-jobs` for clang). With LTO, static libraries are created with `gcc-ar`/`llvm-ar` so the archive index covers the LTO objects.\n\n";
+    
     file << "### debug\n";
     file << "**Type:** boolean (optional)  \n";
     file << "**Default:** `false`  \n";
     file << "**Description:** Include debug symbols in the output (adds `-g` flag).\n\n";
     
+    file << "### linker\n";
+    file << "**Type:** string (optional)  \n";
+    file << "**Default:** `\"auto\"`  \n";
+    file << "**Options:**\n";
+    file << "- `\"auto\"` - Use mold if `ld.mold` is in `PATH`, otherwise lld if `ld.lld` is in `PATH`, otherwise the compiler's default linker. With GCC and `lto` enabled, lld is skipped because it cannot link GCC LTO objects. With GCC, mold is used through `-B` and the `ld` that mold installs in `libexec/mold`, which works with GCC versions older than 12.1; without it mold is skipped\n";
+    file << "- `\"default\"` - Always use the compiler's default linker\n";
+    file << "- `\"bfd\"`, `\"gold\"`, `\"lld\"`, `\"mold\"` - Passed as `-fuse-ld=...` (mold requires GCC 12.1 or newer, or clang)\n\n";
+    file << "**Description:** mold and lld link large programs several times faster than GNU ld (bfd), especially with debug info. Changing the linker relinks the output.\n\n";
+    
+    file << "### split_dwarf\n";
+    file << "**Type:** boolean (optional)  \n";
+    file << "**Default:** `false`  \n";
+    file << "**Description:** Only used with `\"debug\": true`. Compiles with `-gsplit-dwarf`, which leaves most debug info in a `.dwo` file next to each object, so the linker does not have to copy it into the output. Objects are not stored in the compilation cache in this mode.\n\n";
+    
+    file << "### dwp\n";
+    file << "**Type:** boolean (optional)  \n";
+    file << "**Default:** `false`  \n";
+    file << "**Description:** With `split_dwarf`, runs `llvm-dwp` (or binutils `dwp` when `llvm-dwp` is not installed) after linking to collect all `.dwo` files into `<output>.dwp`, which can be shipped or archived together with the binary.\n\n";
+    
+    file << "### compress_debug_sections\n";
+    file << "**Type:** boolean (optional)  \n";
+    file << "**Default:** `false`  \n";
+    file << "**Description:** Only used with `\"debug\": true`. Compresses debug sections in objects and the output (`-gz`), making them smaller to write and read at the cost of some CPU time. With `split_dwarf` only the linked output is compressed, because `.dwo` files must stay readable by `dwp`.\n\n";
+    
+    file << "### thin_archive\n";
+    file << "**Type:** boolean (optional)  \n";
+    file << "**Default:** `false`  \n";
+    file << "**Description:** Only used with `\"output_type\": \"static_library\"`. The archive stores the paths of the object files instead of copies of them, so creating or updating it writes almost nothing. The object files in `build_dir` must be kept as long as the archive is used.\n\n";
+    
     file << "### build_dir\n";
     file << "**Type:** string (optional)  \n";
     file << "**Default:** `\"build\"`  \n";
     file << "**Description:** Directory where object files and output will be placed.\n\n";
     
+    file << "### jobs\n";
+    file << "**Type:** number (optional)  \n";
+    file << "**Default:** `0` (number of CPU cores, limited to one job per 512 MB of available memory)  \n";
+    file << "**Description:** Maximum number of compile jobs running at the same time. Can be overridden with `-j N` on the command line.\n\n";
+    
+    file << "### memory_budget_mb\n";
+    file << "**Type:** number (optional)  \n";
+    file << "**Default:** `0` (available memory when the build starts; no limit where it cannot be determined)  \n";
+    file << "**Description:** Upper bound on the predicted memory of jobs running at the same time. `.buildpp_log` records the peak memory of every compile and link; jobs without a record are assumed to need 512 MB. A job starts only when it fits in the budget together with the running jobs, or when nothing else is running, so a few huge translation units no longer push the machine into swap while small ones still run `jobs` at a time. Jobs sent to `workers` are counted too, because they are compiled locally if the worker fails.\n\n";
+    file << "**Example:**\n";
+    file << "```json\n";
+    file << "\"memory_budget_mb\": 8192\n";
+    file << "```\n\n";
+    
+    file << "### dirty_check\n";
+    file << "**Type:** string (optional)  \n";
+    file << "**Default:** `\"mtime\"`  \n";
+    file << "**Options:**\n";
+    file << "- `\"mtime\"` - Recompile when a source or header is newer than its object file\n";
+    file << "- `\"hash\"` - Recompile only when the contents of a source or header changed. Useful after `git checkout` or restoring a CI cache, which touch modification times without changing files\n\n";
+    
+    file << "### precompiled_header\n";
+    file << "**Type:** string (optional)  \n";
+    file << "**Default:** `\"\"` (disabled)  \n";
+    file << "**Description:** A header (usually including STL, boost, fmt and other heavy headers) that is compiled once into a `.gch`/`.pch` in `build_dir/pch` and automatically included at the top of every source file. It is rebuilt only when the header or one of its own includes changes, and then every source file is recompiled.\n\n";
+    file << "**Example:**\n";
+    file << "```json\n";
+    file << "\"precompiled_header\": \"include/pch.hpp\"\n";
+    file << "```\n\n";
+    
+    file << "### unity_build\n";
+    file << "**Type:** object (optional)  \n";
+    file << "**Default:** none (disabled)  \n";
+    file << "**Description:** Unity (jumbo) build. Sources are grouped into generated files in `build_dir/unity` that `#include` about `batch_size` sources each, and those are compiled instead. This saves process startup and repeated header parsing for projects with many small files. Batches are stable: adding or removing a file only changes the batch it belongs to. Files that do not compile in unity mode (e.g. conflicting static names) can be listed in `exclude` and are compiled individually.\n\n";
+    file << "**Example:**\n";
+    file << "```json\n";
+    file << "\"unity_build\": {\n";
+    file << "  \"batch_size\": 8,\n";
+    file << "  \"exclude\": [\"src/legacy.cpp\"]\n";
+    file << "}\n";
+    file << "```\n\n";
+    
+    file << "### pgo\n";
+    file << "**Type:** object (optional)  \n";
+    file << "**Default:** none (disabled)  \n";
+    file << "**Description:** Profile-guided optimization. `buildpp pgo` builds an instrumented variant (`-fprofile-generate`) in `build_dir/pgo`, runs the `train` command (without a shell; `{build_dir}` is replaced by `build_dir/pgo`, where the instrumented outputs are), merges the profiles (`llvm-profdata` for clang; GCC's `.gcda` files are copied next to the objects of the normal build) and then builds normally with `-fprofile-use`. Later `build` runs keep using the profiles. Profile data is tracked as a compile input, so refreshing it recompiles only the optimized build, and objects compiled with profiles are not stored in the compilation cache.\n\n";
+    file << "**Example:**\n";
+    file << "```json\n";
+    file << "\"pgo\": {\n";
+    file << "  \"train\": [\"{build_dir}/server\", \"--benchmark\", \"data/requests.log\"]\n";
+    file << "}\n";
+    file << "```\n\n";
+    
+    file << "### workers\n";
+    file << "**Type:** array (optional)  \n";
+    file << "**Default:** `[]` (compile locally)  \n";
+    file << "**Description:** Addresses of `buildpp worker` daemons: `\"host:port\"` (TCP) or `\"unix:/path/to/socket\"`. Each source is preprocessed locally and the preprocessed file is sent with the compile flags to a worker, which compiles it and returns the object. Workers are used in turn; one that cannot be reached is skipped for the rest of the build, and a source that fails remotely is compiled locally. With `jobs` set to `0`, the default becomes CPU cores x (1 + number of workers). Sources are compiled locally with `split_dwarf`, during the instrumented step of `buildpp pgo` and with profile data. Workers run the compiler with the same name (without directory) from their own `PATH`, which should be the same version as the local one. They only accept `-O`, `-f`, `-m`, `-W`, `-g` and `-std=` options (excluding plugins, `-Wl,` and others that read or write files), so sources whose `compile_flags` contain anything else fall back to local compilation. Workers do not authenticate clients; only listen on trusted networks.\n\n";
+    file << "**Example:**\n";
+    file << "```json\n";
+    file << "\"workers\": [\"10.0.0.5:7700\", \"10.0.0.6:7700\"]\n";
+    file << "```\n\n";
+    
+    file << "### cache_dir\n";
+    file << "**Type:** string (optional)  \n";
+    file << "**Default:** `\"\"` (disabled)  \n";
+    file << "**Description:** Directory of the local compilation cache. Objects are cached by preprocessed source, compile command and compiler version, so identical translation units (after a branch switch, `rebuild`, or in another build directory) are restored instead of compiled. The cache can be shared between projects. `~` expands to the home directory.\n\n";
+    file << "**Example:**\n";
+    file << "```json\n";
+    file << "\"cache_dir\": \"~/.cache/buildpp\"\n";
+    file << "```\n\n";
+    
+    file << "### cache_max_size_mb\n";
+    file << "**Type:** number (optional)  \n";
+    file << "**Default:** `5120`  \n";
+    file << "**Description:** When the cache grows beyond this size, the least recently used entries are removed.\n\n";
+    
     file << "### source_files\n";
     file << "**Type:** array (required)  \n";
-    file << "**Description:** List of source files or directories to compile.\n\n";
+    file << "**Description:** List of source files, directories or glob patterns to compile.\n\n";
     file << "**Features:**\n";
     file << "- **Individual files:** Specify exact file paths\n";
     file << "- **Directories:** Automatically scans for C++ files (`.cpp`, `.cc`, `.cxx`, `.c++`, `.C`)\n";
-    file << "- **Non-recursive:** Directory scanning only includes files in that directory, not subdirectories\n\n";
+    file << "- **Non-recursive:** Directory scanning only includes files in that directory, not subdirectories\n";
+    file << "- **Glob patterns:** `*`, `?` and `[a-z]` match within one path component, `**` matches any number of directories (`src/**/*.cpp`). Only C++ files are taken from the matches; names starting with `.` and `build_dir` are skipped. The tree is walked in parallel and the matches are sorted by path\n";
+    file << "- **Excludes:** Entries starting with `!` remove matching files, or everything below a matching directory, from all other entries\n\n";
     file << "**Example:**\n";
     file << "```json\n";
     file << "\"source_files\": [\n";
     file << "  \"main.cpp\",\n";
-    file << "  \"src\",\n";
+    file << "  \"src/**/*.cpp\",\n";
+    file << "  \"!src/legacy\",\n";
     file << "  \"utils/helper.cpp\"\n";
     file << "]\n";
     file << "```\n\n";
@@ -385,6 +820,18 @@ bool ConfigParser::generateGuideDocument(const std::string& filename) {
     file << "**Default:** `[]`  \n";
     file << "**Description:** Additional flags to pass to the linker during linking phase.\n\n";
     
+    file << "### targets\n";
+    file << "**Type:** array (optional)  \n";
+    file << "**Default:** none (single target)  \n";
+    file << "**Description:** Builds several libraries and executables from one config file. Each entry needs a `name` and its own `source_files`, and inherits every top-level setting. `output_name`, `output_type`, `cpp_standard`, `optimization`, `debug`, `thin_archive`, `precompiled_header` and `unity_build` can be overridden; `include_dirs`, `library_dirs`, `libraries`, `compile_flags` and `link_flags` are appended to the top-level lists. `deps` lists other targets this one depends on: their `include_dirs` are added, and libraries among them are linked in. Intermediate files go to `build_dir/<name>.dir`, outputs to `build_dir`. All targets are scheduled as one graph, so independent targets compile in parallel and a target links as soon as its own objects and its dependencies are ready. When `targets` is present, top-level `source_files` is not required.\n\n";
+    file << "**Example:**\n";
+    file << "```json\n";
+    file << "\"targets\": [\n";
+    file << "  { \"name\": \"core\", \"output_type\": \"library\", \"source_files\": [\"core\"], \"compile_flags\": [\"-fPIC\"] },\n";
+    file << "  { \"name\": \"app\", \"source_files\": [\"app\"], \"deps\": [\"core\"] }\n";
+    file << "]\n";
+    file << "```\n\n";
+    
     file << "## Examples\n\n";
     
     file << "### Example 1: Simple Executable\n\n";
@@ -510,6 +957,8 @@ bool ConfigParser::generateGuideDocument(const std::string& filename) {
     file << "**Solution:** Run `./buildpp init` to create a default configuration.\n\n";
     file << "**Problem:** \"source_files is required in config file\"  \n";
     file << "**Solution:** Add at least one source file or directory to the `source_files` array.\n\n";
+    file << "**Problem:** \"build.json:3:11: jobs must be an integer\" (or another message with a line and column)  \n";
+    file << "**Solution:** The config file is not valid JSON or a field has the wrong type; fix the value at that line and column. Strings must use double quotes, and there is no comma after the last element.\n\n";
     file << "**Problem:** Directory scanning finds no files  \n";
     file << "**Solution:** Ensure files have correct extensions (`.cpp`, `.cc`, `.cxx`, `.c++`, `.C`) and directory exists.\n\n";
     file << "**Problem:** Linking fails with \"undefined reference\"  \n";
@@ -547,55 +996,56 @@ bool ConfigParser::isDirectory(const std::string& path) {
 #endif
 }
 
-// 列出目录中的所有C++文件
-std::vector<std::string> ConfigParser::listCppFiles(const std::string& directory) {
-    std::vector<std::string> files;
+// 展开source_files中的目录项、通配符模式和排除模式
+std::vector<std::string> ConfigParser::expandSourceFiles(const std::vector<std::string>& entries) {
+    std::vector<std::string> result;
+    TraceSpan span(trace, "Scan source directories", "scan");
     
-#ifdef _WIN32
-    WIN32_FIND_DATA findData;
-    std::string searchPath = directory + "\\*";
-    HANDLE hFind = FindFirstFile(searchPath.c_str(), &findData);
-    
-    if (hFind != INVALID_HANDLE_VALUE) {
-        do {
-            std::string filename = findData.cFileName;
-            if (!(findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
-                if (isCppFile(filename)) {
-                    files.push_back(directory + "/" + filename);
-                }
-            }
-        } while (FindNextFile(hFind, &findData));
-        FindClose(hFind);
-    }
-#else
-    DIR* dir = opendir(directory.c_str());
-    if (dir) {
-        struct dirent* entry;
-        while ((entry = readdir(dir)) != nullptr) {
-            std::string filename = entry->d_name;
-            if (entry->d_type == DT_REG && isCppFile(filename)) {
-                files.push_back(directory + "/" + filename);
-            }
+    // 以 ! 开头的项为排除模式，作用于其他所有项；遍历目录树时不进入构建目录（其中有生成的源文件）
+    std::vector<std::string> excludes;
+    for (const auto& entry : entries) {
+        if (entry[0] == '!') {
+            excludes.push_back(entry.substr(1));
         }
-        closedir(dir);
     }
-#endif
+    std::vector<std::string> walkExcludes = excludes;
+    walkExcludes.push_back(config.build_dir);
     
-    return files;
-}
-
-// 展开source_files中的目录项
-std::vector<std::string> ConfigParser::expandSourceFiles(const std::vector<std::string>& entries) {
-    std::vector<std::string> result;
+    // 目录列表缓存在第一次扫描时从构建目录中读取
+    if (!dirCacheLoaded) {
+        dirCache.load(config.build_dir + "/.buildpp_dirs");
+        dirCacheLoaded = true;
+    }
     
+    std::set<std::string> seen;
     for (const auto& entry : entries) {
-        if (isDirectory(entry)) {
-            std::cout << "Scanning directory: " << entry << std::endl;
-            std::vector<std::string> files = listCppFiles(entry);
-            std::cout << "  Found " << files.size() << " C++ files" << std::endl;
-            result.insert(result.end(), files.begin(), files.end());
+        std::vector<std::string> files;
+        if (entry[0] == '!') {
+            continue;
+        }
+        
+        // 目录按模式 "目录/*" 处理（不包括子目录）；只有实际重新读取了目录时才输出扫描信息
+        bool isPattern = hasGlobChars(entry);
+        if (isPattern || isDirectory(entry)) {
+            size_t listedDirs = 0;
+            for (const auto& file : globFiles(isPattern ? entry : entry + "/*", walkExcludes, &dirCache, &listedDirs)) {
+                if (isCppFile(file)) {
+                    files.push_back(file);
+                }
+            }
+            if (listedDirs > 0) {
+                std::cout << (isPattern ? "Scanning pattern: " : "Scanning directory: ") << entry << std::endl;
+                std::cout << "  Found " << files.size() << " C++ files" << std::endl;
+            }
         } else {
-            result.push_back(entry);
+            files.push_back(entry);
+        }
+        
+        // 同一个文件被多项匹配时只保留第一次出现的位置
+        for (const auto& file : files) {
+            if (!isExcludedPath(file, excludes) && seen.insert(file).second) {
+                result.push_back(file);
+            }
         }
     }
     
@@ -1,17 +1,27 @@
 #ifndef CONFIG_HPP
 #define CONFIG_HPP
 
+#include "dircache.hpp"
 #include <string>
 #include <vector>
 #include <map>
 
+class BuildTrace;
+class JsonValue;
+
 struct BuildConfig {
     std::string project_name;
     std::string output_name;
-    std::string output_type; // "executable" or "library"
+    std::string output_type; // "executable"、"library" 或 "static_library"
     std::string cpp_standard; // "c++11", "c++14", "c++17", "c++20", etc.
     std::string optimization; // "O0", "O1", "O2", "O3", "Os"
+    std::string lto; // 链接时优化："off"、"full" 或 "thin"
     bool debug;
+    int jobs; // 并行编译任务数，0 表示根据CPU核心数和可用内存确定
+    int memory_budget_mb; // 同时运行的任务的预计内存之和的上限（MB），0 表示使用系统的可用内存
+    std::string dirty_check; // "mtime" 或 "hash"
+    std::string cache_dir; // 编译缓存目录，为空时不使用缓存
+    int cache_max_size_mb; // 编译缓存大小上限（MB）
     
     std::vector<std::string> source_files;
     std::vector<std::string> include_dirs;
@@ -22,11 +32,42 @@ struct BuildConfig {
     
     std::string build_dir;
     std::string compiler; // "g++" or "gcc"
+    std::string precompiled_header; // 预编译头文件，为空时不使用
+    
+    // 链接器和调试信息
+    std::string linker; // "auto"、"default"、"bfd"、"gold"、"lld" 或 "mold"
+    bool split_dwarf; // 调试信息写入单独的 .dwo 文件（-gsplit-dwarf）
+    bool dwp; // 链接后把 .dwo 文件打包为 .dwp
+    bool compress_debug_sections; // 压缩调试信息（-gz）
+    
+    // 静态库使用 thin archive：只记录目标文件的路径，不复制其内容
+    bool thin_archive;
+    
+    // 输出文件所在目录，为空时为 build_dir（多目标构建时所有目标输出到同一目录）
+    std::string output_dir;
+    
+    // 多目标构建：每个目标是一份完整的配置，target_deps 为它依赖的其他目标
+    std::string target_name;
+    std::vector<std::string> target_deps;
+    std::vector<BuildConfig> targets;
+    
+    // 配置文件驱动的优化（buildpp pgo）
+    std::vector<std::string> pgo_train; // 训练命令，其中的 {build_dir} 替换为插桩构建的目录
+    std::string pgo_dir; // 插桩构建和训练数据所在目录（build_dir/pgo），不使用 PGO 时为空
+    bool pgo_instrument; // 插桩构建（-fprofile-generate），否则有训练数据时使用（-fprofile-use）
+    
+    // 合并编译（unity build）
+    int unity_batch_size; // 每个合并编译单元包含的源文件数，0 表示不使用
+    std::vector<std::string> unity_exclude; // 不参与合并、单独编译的源文件
+    
+    // 分布式编译：buildpp worker 的地址（"host:port" 或 "unix:/path"），为空时只在本机编译
+    std::vector<std::string> workers;
 };
 
 class ConfigParser {
 public:
-    ConfigParser();
+    // trace 不为空时记录解析配置和扫描目录的耗时
+    ConfigParser(BuildTrace* trace = nullptr);
     bool loadFromFile(const std::string& filename);
     const BuildConfig& getConfig() const { return config; }
     void printConfig() const;
@@ -37,16 +78,29 @@ public:
     
 private:
     BuildConfig config;
-    bool parseJson(const std::string& content);
-    std::string trim(const std::string& str);
-    std::string extractString(const std::string& json, const std::string& key);
-    std::vector<std::string> extractArray(const std::string& json, const std::string& key);
-    bool extractBool(const std::string& json, const std::string& key, bool defaultValue = false);
+    BuildTrace* trace;
+    DirectoryCache dirCache;
+    bool dirCacheLoaded;
+    std::string configFile;
+    
+    // 从解析后的 JSON 树读取配置
+    bool parseConfig(const JsonValue& root);
+    bool parseTarget(const JsonValue& object, BuildConfig& target);
+    
+    // 读取对象中的字段：字段不存在时保持原值，类型不符时报告错误的位置并返回 false
+    bool readString(const JsonValue& object, const char* key, std::string& value);
+    bool readBool(const JsonValue& object, const char* key, bool& value);
+    bool readInt(const JsonValue& object, const char* key, int& value);
+    bool readStringArray(const JsonValue& object, const char* key, std::vector<std::string>& values);
+    bool readUnityBuild(const JsonValue& object, BuildConfig& target);
+    bool readPgo(const JsonValue& object, BuildConfig& target);
+    
+    // 在值所在的行和列报告错误，总是返回 false
+    bool reportError(const JsonValue& value, const std::string& message);
     
     // 文件夹扫描相关方法
     std::vector<std::string> expandSourceFiles(const std::vector<std::string>& entries);
     bool isDirectory(const std::string& path);
-    std::vector<std::string> listCppFiles(const std::string& directory);
     bool isCppFile(const std::string& filename);
 };
 
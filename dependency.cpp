@@ -1,68 +1,261 @@
 #include "dependency.hpp"
+#include "hash.hpp"
 #include <iostream>
+#include <vector>
+#include <set>
 
-#ifdef _WIN32
-#include <windows.h>
-#include <sys/types.h>
-#include <sys/stat.h>
-#else
-#include <sys/stat.h>
-#include <unistd.h>
-#endif
+DependencyChecker::DependencyChecker() : snapshot(&ownSnapshot), contentHashing(false) {
+}
+
+void DependencyChecker::setContentHashing(bool enabled) {
+    contentHashing = enabled;
+}
 
-DependencyChecker::DependencyChecker() {
+void DependencyChecker::setSnapshot(FileSnapshot* shared) {
+    snapshot = shared ? shared : &ownSnapshot;
 }
 
 bool DependencyChecker::fileExists(const std::string& filename) {
-#ifdef _WIN32
-    struct _stat buffer;
-    return (_stat(filename.c_str(), &buffer) == 0);
-#else
-    struct stat buffer;
-    return (stat(filename.c_str(), &buffer) == 0);
-#endif
+    return statPath(filename).exists;
+}
+
+bool DependencyChecker::inputExists(const std::string& filename) {
+    return snapshot->get(filename).exists;
+}
+
+void DependencyChecker::prefetchFileInfo(const std::vector<std::string>& sourceFiles,
+                                         const std::vector<std::string>& objectFiles) {
+    // 很多源文件包含相同的头文件，去重后每个路径只读取一次
+    std::set<std::string> paths(sourceFiles.begin(), sourceFiles.end());
+    paths.insert(objectFiles.begin(), objectFiles.end());
+    for (const auto& objectFile : objectFiles) {
+        std::vector<std::string> deps;
+        if (depsLog.getDeps(objectFile, deps)) {
+            paths.insert(deps.begin(), deps.end());
+        }
+    }
+    snapshot->prefetch(std::vector<std::string>(paths.begin(), paths.end()));
+}
+
+void DependencyChecker::invalidateFile(const std::string& filename) {
+    snapshot->invalidate(filename);
+}
+
+bool DependencyChecker::getDeps(const std::string& objectFile, std::vector<std::string>& deps) const {
+    return depsLog.getDeps(objectFile, deps);
 }
 
 time_t DependencyChecker::getFileModTime(const std::string& filename) {
-    // 检查缓存
-    auto it = fileTimeCache.find(filename);
-    if (it != fileTimeCache.end()) {
-        return it->second;
+    return static_cast<time_t>(snapshot->get(filename).modTimeNs / 1000000000ULL);
+}
+
+uint64_t DependencyChecker::hashFileInfo(uint64_t hash, const std::string& filename, const FileStat& info) {
+    hash = hashString(filename, hash);
+    hash = hashCombine(hash, info.modTimeNs);
+    hash = hashCombine(hash, info.size);
+    return hashCombine(hash, info.inode);
+}
+
+bool DependencyChecker::hashFileContents(const std::vector<std::string>& inputs, uint64_t& inputHash) {
+    inputHash = 0;
+    for (const auto& input : inputs) {
+        uint64_t contentHash;
+        if (!hashCache.getHash(input, snapshot->get(input), contentHash)) {
+            return false;
+        }
+        inputHash = hashCombine(hashString(input, inputHash), contentHash);
+    }
+    return true;
+}
+
+bool DependencyChecker::openLogs(const std::string& buildDir) {
+    bool depsOk = depsLog.open(buildDir + "/.buildpp_deps");
+    bool buildOk = buildLog.load(buildDir + "/.buildpp_log");
+    if (contentHashing) {
+        hashCache.load(buildDir + "/.buildpp_hashes");
+    }
+    return depsOk && buildOk;
+}
+
+bool DependencyChecker::closeLogs() {
+    depsLog.close();
+    if (contentHashing) {
+        hashCache.save();
+    }
+    return buildLog.save();
+}
+
+bool DependencyChecker::recordCompile(const std::string& objectFile, const std::string& depFile,
+                                      const std::string& command,
+                                      const std::vector<std::string>& extraInputs, uint64_t durationMs,
+                                      uint64_t peakMemoryKb) {
+    std::vector<std::string> deps;
+    if (!DepsLog::parseDepFile(depFile, deps)) {
+        return false;
+    }
+    depsLog.recordDeps(objectFile, deps);
+    deps.insert(deps.end(), extraInputs.begin(), extraInputs.end());
+    
+    // 依赖列表中包含源文件本身
+    uint64_t inputHash;
+    if (!hashInputs(deps, inputHash)) {
+        return false;
+    }
+    buildLog.record(objectFile, hashString(command), inputHash, durationMs, peakMemoryKb);
+    return true;
+}
+
+bool DependencyChecker::hashInputs(const std::vector<std::string>& inputs, uint64_t& inputHash) {
+    if (contentHashing) {
+        return hashFileContents(inputs, inputHash);
+    }
+    
+    inputHash = 0;
+    for (const auto& input : inputs) {
+        FileStat info = snapshot->get(input);
+        if (!info.exists) {
+            return false;
+        }
+        inputHash = hashFileInfo(inputHash, input, info);
+    }
+    return true;
+}
+
+bool DependencyChecker::needsRelink(const std::string& outputFile, const std::string& command,
+                                    const std::vector<std::string>& inputs) {
+    if (!snapshot->get(outputFile).exists) {
+        return true;
     }
     
-#ifdef _WIN32
-    struct _stat fileInfo;
-    if (_stat(filename.c_str(), &fileInfo) != 0) {
-        return 0;
+    BuildLogEntry entry;
+    if (!buildLog.find(outputFile, entry) || entry.commandHash != hashString(command)) {
+        return true;
     }
-#else
-    struct stat fileInfo;
-    if (stat(filename.c_str(), &fileInfo) != 0) {
-        return 0;
+    
+    // 编译任务完成后已从快照中去掉其目标文件，这里读取的是新的信息
+    uint64_t inputHash;
+    if (!hashInputs(inputs, inputHash)) {
+        return true;
+    }
+    return inputHash != entry.inputHash;
+}
+
+bool DependencyChecker::recordLink(const std::string& outputFile, const std::string& command,
+                                   const std::vector<std::string>& inputs, uint64_t durationMs,
+                                   uint64_t peakMemoryKb) {
+    uint64_t inputHash;
+    if (!hashInputs(inputs, inputHash)) {
+        return false;
+    }
+    buildLog.record(outputFile, hashString(command), inputHash, durationMs, peakMemoryKb);
+    return true;
+}
+
+uint64_t DependencyChecker::getDuration(const std::string& outputFile) const {
+    BuildLogEntry entry;
+    return buildLog.find(outputFile, entry) ? entry.durationMs : 0;
+}
+
+uint64_t DependencyChecker::getPeakMemory(const std::string& outputFile) const {
+    BuildLogEntry entry;
+    return buildLog.find(outputFile, entry) ? entry.peakMemoryKb : 0;
+}
+
+// 成员的记录以 "静态库(目标文件)" 为键，与 make 中静态库成员的写法相同
+static std::string memberKey(const std::string& archive, const std::string& object) {
+    return archive + "(" + object + ")";
+}
+
+std::vector<std::string> DependencyChecker::changedMembers(const std::string& archive,
+                                                           const std::string& command,
+                                                           const std::vector<std::string>& objects) {
+    // 归档命令包含所有成员，增删源文件后重新创建静态库，不会留下多余的成员
+    BuildLogEntry entry;
+    if (!snapshot->get(archive).exists || !buildLog.find(archive, entry) ||
+        entry.commandHash != hashString(command)) {
+        return objects;
     }
-#endif
     
-    time_t modTime = fileInfo.st_mtime;
-    fileTimeCache[filename] = modTime;
-    return modTime;
+    std::vector<std::string> changed;
+    for (const auto& object : objects) {
+        uint64_t inputHash;
+        if (!buildLog.find(memberKey(archive, object), entry) ||
+            !hashInputs(std::vector<std::string>{object}, inputHash) || inputHash != entry.inputHash) {
+            changed.push_back(object);
+        }
+    }
+    return changed;
+}
+
+bool DependencyChecker::recordMembers(const std::string& archive, const std::vector<std::string>& objects) {
+    for (const auto& object : objects) {
+        uint64_t inputHash;
+        if (!hashInputs(std::vector<std::string>{object}, inputHash)) {
+            return false;
+        }
+        buildLog.record(memberKey(archive, object), 0, inputHash);
+    }
+    return true;
 }
 
-bool DependencyChecker::needsRecompile(const std::string& sourceFile, const std::string& objectFile) {
+bool DependencyChecker::needsRecompile(const std::string& sourceFile, const std::string& objectFile,
+                                       const std::string& command,
+                                       const std::vector<std::string>& extraInputs) {
     // 如果目标文件不存在，需要编译
-    if (!fileExists(objectFile)) {
+    FileStat object = snapshot->get(objectFile);
+    if (!object.exists) {
         return true;
     }
     
     // 如果源文件不存在，报错
-    if (!fileExists(sourceFile)) {
+    FileStat source = snapshot->get(sourceFile);
+    if (!source.exists) {
         std::cerr << "Error: Source file does not exist: " << sourceFile << std::endl;
         return false;
     }
     
-    // 比较修改时间
-    time_t sourceTime = getFileModTime(sourceFile);
-    time_t objectTime = getFileModTime(objectFile);
+    // 编译命令（编译选项、标准、优化级别等）发生变化，需要重新编译
+    BuildLogEntry entry;
+    if (!buildLog.find(objectFile, entry) || entry.commandHash != hashString(command)) {
+        return true;
+    }
+    
+    // 哈希模式下只比较输入文件的内容，修改时间的变化不会触发重新编译
+    if (contentHashing) {
+        std::vector<std::string> deps;
+        uint64_t inputHash;
+        if (!depsLog.getDeps(objectFile, deps)) {
+            return true;
+        }
+        deps.insert(deps.end(), extraInputs.begin(), extraInputs.end());
+        if (!hashFileContents(deps, inputHash)) {
+            return true;
+        }
+        return inputHash != entry.inputHash;
+    }
+    
+    // 如果源文件比目标文件新，需要重新编译（比较纳秒精度的修改时间）
+    if (source.modTimeNs > object.modTimeNs) {
+        return true;
+    }
+    
+    // 没有依赖记录时无法判断头文件是否修改，重新编译以生成依赖信息
+    std::vector<std::string> deps;
+    if (!depsLog.getDeps(objectFile, deps)) {
+        return true;
+    }
+    deps.insert(deps.end(), extraInputs.begin(), extraInputs.end());
+    
+    // 任何依赖的头文件被删除或比目标文件新，都需要重新编译
+    uint64_t inputHash = 0;
+    for (const auto& dep : deps) {
+        FileStat info = snapshot->get(dep);
+        if (!info.exists || info.modTimeNs > object.modTimeNs) {
+            return true;
+        }
+        inputHash = hashFileInfo(inputHash, dep, info);
+    }
     
-    // 如果源文件比目标文件新，需要重新编译
-    return sourceTime > objectTime;
+    // 输入文件被替换为旧版本时修改时间不会变新，通过指纹发现
+    return inputHash != entry.inputHash;
 }
@@ -1,25 +1,101 @@
 #ifndef DEPENDENCY_HPP
 #define DEPENDENCY_HPP
 
+#include "depslog.hpp"
+#include "buildlog.hpp"
+#include "filehash.hpp"
+#include "filestat.hpp"
 #include <string>
-#include <map>
-#include <sys/stat.h>
+#include <vector>
+#include <cstdint>
+#include <ctime>
 
 class DependencyChecker {
 public:
     DependencyChecker();
     
-    // 检查源文件是否需要重新编译
-    bool needsRecompile(const std::string& sourceFile, const std::string& objectFile);
+    // 使用文件内容哈希（而不是修改时间）判断输入是否变化
+    void setContentHashing(bool enabled);
     
-    // 获取文件的最后修改时间
+    // 使用多个目标共用的文件信息快照（默认使用自己的快照）
+    void setSnapshot(FileSnapshot* shared);
+    
+    // 并行读取源文件、目标文件和上次记录的依赖的信息，之后的检查不再逐个 stat
+    void prefetchFileInfo(const std::vector<std::string>& sourceFiles,
+                          const std::vector<std::string>& objectFiles);
+    
+    // 检查源文件是否需要重新编译（包括其依赖的头文件和编译命令）
+    // extraInputs 为依赖文件中没有列出的其他输入（如预编译头）
+    bool needsRecompile(const std::string& sourceFile, const std::string& objectFile,
+                        const std::string& command,
+                        const std::vector<std::string>& extraInputs = std::vector<std::string>());
+    
+    // 打开构建目录中的头文件依赖日志和构建日志
+    bool openLogs(const std::string& buildDir);
+    
+    // 保存构建日志
+    bool closeLogs();
+    
+    // 编译完成后解析 .d 文件，记录依赖、编译命令、输入指纹、编译耗时和编译器的峰值内存
+    bool recordCompile(const std::string& objectFile, const std::string& depFile,
+                       const std::string& command,
+                       const std::vector<std::string>& extraInputs = std::vector<std::string>(),
+                       uint64_t durationMs = 0, uint64_t peakMemoryKb = 0);
+    
+    // 检查链接输出是否需要重新生成：输出不存在、链接命令变化或任一输入（目标文件、库）变化
+    bool needsRelink(const std::string& outputFile, const std::string& command,
+                     const std::vector<std::string>& inputs);
+    
+    // 链接完成后记录链接命令、输入指纹、链接耗时和链接器的峰值内存
+    bool recordLink(const std::string& outputFile, const std::string& command,
+                    const std::vector<std::string>& inputs, uint64_t durationMs = 0,
+                    uint64_t peakMemoryKb = 0);
+    
+    // 上次生成输出文件的耗时（毫秒），没有记录时返回 0
+    uint64_t getDuration(const std::string& outputFile) const;
+    
+    // 上次生成输出文件时编译器或链接器的峰值内存（KB），没有记录时返回 0
+    uint64_t getPeakMemory(const std::string& outputFile) const;
+    
+    // 静态库中需要更新的成员：静态库不存在或归档命令变化时返回全部目标文件，
+    // 否则只返回上次归档之后发生变化的目标文件
+    std::vector<std::string> changedMembers(const std::string& archive, const std::string& command,
+                                            const std::vector<std::string>& objects);
+    
+    // 归档完成后记录每个成员的指纹
+    bool recordMembers(const std::string& archive, const std::vector<std::string>& objects);
+    
+    // 文件发生变化，丢弃快照中的文件信息
+    void invalidateFile(const std::string& filename);
+    
+    // 获取上次编译记录的目标文件依赖（包括源文件本身）
+    bool getDeps(const std::string& objectFile, std::vector<std::string>& deps) const;
+    
+    // 获取文件的最后修改时间（使用快照）
     time_t getFileModTime(const std::string& filename);
     
-    // 检查文件是否存在
+    // 检查文件是否存在（不使用快照，用于构建目录等会在构建中创建的路径）
     bool fileExists(const std::string& filename);
     
+    // 检查构建中不会改变的输入文件（如 PGO 训练数据）是否存在（使用快照）
+    bool inputExists(const std::string& filename);
+    
 private:
-    std::map<std::string, time_t> fileTimeCache;
+    FileSnapshot ownSnapshot;
+    FileSnapshot* snapshot;
+    DepsLog depsLog;
+    BuildLog buildLog;
+    FileHashCache hashCache;
+    bool contentHashing;
+    
+    // 根据输入文件的修改时间（纳秒）、大小和 inode 计算指纹
+    static uint64_t hashFileInfo(uint64_t hash, const std::string& filename, const FileStat& info);
+    
+    // 根据输入文件的内容计算指纹，任一文件无法读取时返回 false
+    bool hashFileContents(const std::vector<std::string>& inputs, uint64_t& inputHash);
+    
+    // 按当前模式（内容哈希或修改时间和大小）计算输入指纹（可在编译线程中调用）
+    bool hashInputs(const std::vector<std::string>& inputs, uint64_t& inputHash);
 };
 
 #endif // DEPENDENCY_HPP
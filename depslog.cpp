@@ -0,0 +1,301 @@
+#include "depslog.hpp"
+#include "filestat.hpp"
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <cstring>
+
+// 文件格式：
+//   文件头: "BPDL" + uint32 版本号
+//   记录:   uint32 头部（最高位为1表示依赖记录，低31位为数据长度）+ 数据
+//     路径记录: 路径字符串，编号按出现顺序递增
+//     依赖记录: uint32 目标文件编号 + 若干 uint32 依赖文件编号
+static const char DEPS_LOG_MAGIC[4] = {'B', 'P', 'D', 'L'};
+static const uint32_t DEPS_LOG_VERSION = 1;
+static const uint32_t DEPS_RECORD_FLAG = 0x80000000u;
+
+static void appendUint32(std::string& buffer, uint32_t value) {
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static uint32_t readUint32(const std::string& buffer, size_t offset) {
+    uint32_t value;
+    memcpy(&value, buffer.data() + offset, sizeof(value));
+    return value;
+}
+
+DepsLog::DepsLog() : file(nullptr), recordCount(0), fileSize(0), loaded(false) {
+}
+
+DepsLog::~DepsLog() {
+    close();
+}
+
+void DepsLog::close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (file) {
+        fclose(file);
+        file = nullptr;
+    }
+}
+
+bool DepsLog::load(std::string& content) {
+    paths.clear();
+    pathIds.clear();
+    objectDeps.clear();
+    recordCount = 0;
+    
+    if (content.size() < 8 || memcmp(content.data(), DEPS_LOG_MAGIC, 4) != 0 ||
+        readUint32(content, 4) != DEPS_LOG_VERSION) {
+        return false;
+    }
+    
+    size_t offset = 8;
+    while (offset + 4 <= content.size()) {
+        uint32_t header = readUint32(content, offset);
+        uint32_t size = header & ~DEPS_RECORD_FLAG;
+        if (offset + 4 + size > content.size()) {
+            // 上次构建中断时可能留下不完整的记录
+            return false;
+        }
+        
+        if (header & DEPS_RECORD_FLAG) {
+            if (size < 4 || size % 4 != 0) return false;
+            uint32_t objectId = readUint32(content, offset + 4);
+            std::vector<uint32_t> deps;
+            for (size_t pos = offset + 8; pos < offset + 4 + size; pos += 4) {
+                deps.push_back(readUint32(content, pos));
+            }
+            if (objectId >= paths.size()) return false;
+            for (uint32_t id : deps) {
+                if (id >= paths.size()) return false;
+            }
+            objectDeps[objectId] = deps;
+        } else {
+            std::string path = content.substr(offset + 4, size);
+            pathIds[path] = static_cast<uint32_t>(paths.size());
+            paths.push_back(path);
+        }
+        
+        recordCount++;
+        offset += 4 + size;
+    }
+    
+    return offset == content.size();
+}
+
+bool DepsLog::open(const std::string& logFile) {
+    close();
+    std::lock_guard<std::mutex> lock(mutex);
+    
+    // 之后的编译结果都已写入内存和文件，文件大小不变说明没有其他进程修改过它，不再重新读取
+    FileStat info = statPath(logFile);
+    bool valid = true;
+    if (!loaded || filename != logFile || !info.exists || info.size != fileSize) {
+        filename = logFile;
+        std::ifstream in(filename, std::ios::binary);
+        std::string content;
+        if (in.is_open()) {
+            std::stringstream buffer;
+            buffer << in.rdbuf();
+            content = buffer.str();
+        }
+        in.close();
+        
+        valid = load(content);
+        fileSize = content.size();
+    }
+    loaded = false;
+    
+    // 日志损坏或过期记录太多时重写为紧凑格式
+    size_t liveRecords = paths.size() + objectDeps.size();
+    if (!valid || (recordCount > 1000 && recordCount > liveRecords * 2)) {
+        if (!recompact()) {
+            return false;
+        }
+    }
+    
+    file = fopen(filename.c_str(), "ab");
+    if (!file) {
+        std::cerr << "Warning: Cannot open dependency log: " << filename << std::endl;
+        return false;
+    }
+    loaded = true;
+    return true;
+}
+
+bool DepsLog::recompact() {
+    std::string tempFile = filename + ".tmp";
+    std::string content(DEPS_LOG_MAGIC, 4);
+    appendUint32(content, DEPS_LOG_VERSION);
+    
+    // 只保留仍被引用的路径，并重新编号
+    std::vector<std::string> oldPaths;
+    oldPaths.swap(paths);
+    std::unordered_map<uint32_t, std::vector<uint32_t>> oldDeps;
+    oldDeps.swap(objectDeps);
+    pathIds.clear();
+    recordCount = 0;
+    
+    for (const auto& entry : oldDeps) {
+        std::string record;
+        uint32_t objectId = internPath(oldPaths[entry.first], record);
+        std::vector<uint32_t> deps;
+        for (uint32_t id : entry.second) {
+            deps.push_back(internPath(oldPaths[id], record));
+        }
+        
+        appendUint32(record, DEPS_RECORD_FLAG | static_cast<uint32_t>(4 + deps.size() * 4));
+        appendUint32(record, objectId);
+        for (uint32_t id : deps) {
+            appendUint32(record, id);
+        }
+        objectDeps[objectId] = deps;
+        recordCount++;
+        content += record;
+    }
+    
+    std::ofstream out(tempFile, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "Warning: Cannot write dependency log: " << tempFile << std::endl;
+        return false;
+    }
+    out.write(content.data(), content.size());
+    out.close();
+    
+#ifdef _WIN32
+    std::remove(filename.c_str());
+#endif
+    fileSize = content.size();
+    return std::rename(tempFile.c_str(), filename.c_str()) == 0;
+}
+
+uint32_t DepsLog::internPath(const std::string& path, std::string& record) {
+    auto it = pathIds.find(path);
+    if (it != pathIds.end()) {
+        return it->second;
+    }
+    
+    uint32_t id = static_cast<uint32_t>(paths.size());
+    paths.push_back(path);
+    pathIds[path] = id;
+    appendUint32(record, static_cast<uint32_t>(path.size()));
+    record += path;
+    recordCount++;
+    return id;
+}
+
+bool DepsLog::writeRecord(const std::string& record) {
+    if (!file) {
+        loaded = false;
+        return false;
+    }
+    if (fwrite(record.data(), 1, record.size(), file) != record.size() || fflush(file) != 0) {
+        // 文件中可能只写入了一部分，下次打开时重新读取
+        loaded = false;
+        return false;
+    }
+    fileSize += record.size();
+    return true;
+}
+
+bool DepsLog::recordDeps(const std::string& objectFile, const std::vector<std::string>& deps) {
+    std::lock_guard<std::mutex> lock(mutex);
+    
+    std::string record;
+    uint32_t objectId = internPath(objectFile, record);
+    std::vector<uint32_t> depIds;
+    for (const auto& dep : deps) {
+        depIds.push_back(internPath(dep, record));
+    }
+    
+    auto it = objectDeps.find(objectId);
+    if (it != objectDeps.end() && it->second == depIds) {
+        return true;
+    }
+    
+    appendUint32(record, DEPS_RECORD_FLAG | static_cast<uint32_t>(4 + depIds.size() * 4));
+    appendUint32(record, objectId);
+    for (uint32_t id : depIds) {
+        appendUint32(record, id);
+    }
+    objectDeps[objectId] = depIds;
+    recordCount++;
+    
+    return writeRecord(record);
+}
+
+bool DepsLog::getDeps(const std::string& objectFile, std::vector<std::string>& deps) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    
+    auto pathIt = pathIds.find(objectFile);
+    if (pathIt == pathIds.end()) {
+        return false;
+    }
+    auto depsIt = objectDeps.find(pathIt->second);
+    if (depsIt == objectDeps.end()) {
+        return false;
+    }
+    
+    deps.clear();
+    for (uint32_t id : depsIt->second) {
+        deps.push_back(paths[id]);
+    }
+    return true;
+}
+
+bool DepsLog::parseDepFile(const std::string& depFile, std::vector<std::string>& deps) {
+    std::ifstream in(depFile, std::ios::binary);
+    if (!in.is_open()) {
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    std::string content = buffer.str();
+    
+    // Makefile 规则格式: "target: dep1 dep2 \<换行> dep3"
+    deps.clear();
+    bool inTargets = true;
+    bool foundRule = false;
+    std::string token;
+    
+    auto flush = [&]() {
+        if (token.empty()) return;
+        if (inTargets) {
+            if (token.back() == ':') {
+                inTargets = false;
+                foundRule = true;
+                token.pop_back();
+            }
+        } else {
+            deps.push_back(token);
+        }
+        token.clear();
+    };
+    
+    for (size_t i = 0; i < content.size(); i++) {
+        char c = content[i];
+        char next = i + 1 < content.size() ? content[i + 1] : '\0';
+        
+        if (c == '\\' && (next == '\n' || next == '\r')) {
+            // 续行
+            flush();
+            i += (next == '\r' && i + 2 < content.size() && content[i + 2] == '\n') ? 2 : 1;
+        } else if (c == '\\' && (next == ' ' || next == '#')) {
+            token += next;
+            i++;
+        } else if (c == '$' && next == '$') {
+            token += '$';
+            i++;
+        } else if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+            flush();
+            // 只解析第一条规则
+            if (c == '\n' && !inTargets) break;
+        } else {
+            token += c;
+        }
+    }
+    flush();
+    
+    return foundRule;
+}
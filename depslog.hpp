@@ -0,0 +1,52 @@
+#ifndef DEPSLOG_HPP
+#define DEPSLOG_HPP
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <cstdio>
+#include <cstdint>
+
+// 头文件依赖日志
+// 以追加方式记录每个目标文件依赖的头文件，路径只保存一次并以编号引用，
+// 之后的构建直接读取此文件，无需再解析每个 .d 文件
+class DepsLog {
+public:
+    DepsLog();
+    ~DepsLog();
+    
+    // 读取日志文件，并打开以便追加新记录；再次打开同一文件且它没有被其他进程修改时
+    // 直接使用内存中的记录（watch 模式的每次构建不再重新读取）
+    bool open(const std::string& filename);
+    
+    // 关闭日志文件
+    void close();
+    
+    // 记录目标文件的依赖列表（与已有记录相同时不写入）
+    bool recordDeps(const std::string& objectFile, const std::vector<std::string>& deps);
+    
+    // 获取目标文件的依赖列表，没有记录时返回 false
+    bool getDeps(const std::string& objectFile, std::vector<std::string>& deps) const;
+    
+    // 解析编译器生成的 .d 依赖文件
+    static bool parseDepFile(const std::string& depFile, std::vector<std::string>& deps);
+    
+private:
+    std::string filename;
+    FILE* file;
+    std::vector<std::string> paths;
+    std::unordered_map<std::string, uint32_t> pathIds;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> objectDeps;
+    size_t recordCount;
+    uint64_t fileSize;  // 内存中的记录对应的文件大小
+    bool loaded;        // 内存中的记录与 filename 一致
+    mutable std::mutex mutex;
+    
+    bool load(std::string& content);
+    bool recompact();
+    uint32_t internPath(const std::string& path, std::string& record);
+    bool writeRecord(const std::string& record);
+};
+
+#endif // DEPSLOG_HPP
@@ -0,0 +1,180 @@
+#include "dircache.hpp"
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+
+// 文件格式：
+//   文件头: "BPDC" + uint32 版本号 + uint64 保存时间（纳秒）+ uint64 目录数
+//   目录:   uint32 路径长度 + 路径 + 修改时间、inode（各 uint64）+ uint32 项数
+//   项:     uint8 类型（1 文件，2 目录，0 其他）+ uint32 名称长度 + 名称
+static const char DIR_CACHE_MAGIC[4] = {'B', 'P', 'D', 'C'};
+static const uint32_t DIR_CACHE_VERSION = 1;
+
+// 修改时间接近保存时间的目录不可信：目录可能在读取后的同一时间戳内又被修改。
+// 这些目录下次会重新读取
+static const uint64_t RACY_MARGIN_NS = 2000000000ULL;
+
+static uint64_t nowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+template <typename T>
+static void appendValue(std::string& buffer, T value) {
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+static bool readValue(const std::string& buffer, size_t& offset, T& value) {
+    if (offset + sizeof(value) > buffer.size()) return false;
+    memcpy(&value, buffer.data() + offset, sizeof(value));
+    offset += sizeof(value);
+    return true;
+}
+
+static bool readString(const std::string& buffer, size_t& offset, std::string& value) {
+    uint32_t length;
+    if (!readValue(buffer, offset, length) || offset + length > buffer.size()) {
+        return false;
+    }
+    value = buffer.substr(offset, length);
+    offset += length;
+    return true;
+}
+
+DirectoryCache::DirectoryCache() : savedAtNs(0), dirty(false) {
+}
+
+bool DirectoryCache::load(const std::string& cacheFile) {
+    std::lock_guard<std::mutex> lock(mutex);
+    filename = cacheFile;
+    directories.clear();
+    savedAtNs = 0;
+    dirty = false;
+    
+    std::ifstream in(filename, std::ios::binary);
+    if (!in.is_open()) {
+        return true;
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    std::string content = buffer.str();
+    
+    size_t offset = 4;
+    uint32_t version = 0;
+    uint64_t count = 0;
+    if (content.size() < 4 || memcmp(content.data(), DIR_CACHE_MAGIC, 4) != 0 ||
+        !readValue(content, offset, version) || version != DIR_CACHE_VERSION ||
+        !readValue(content, offset, savedAtNs) || !readValue(content, offset, count)) {
+        std::cerr << "Warning: Ignoring invalid directory cache: " << filename << std::endl;
+        savedAtNs = 0;
+        return false;
+    }
+    
+    for (uint64_t i = 0; i < count; i++) {
+        std::string path;
+        Entry entry;
+        uint32_t entryCount;
+        if (!readString(content, offset, path) || !readValue(content, offset, entry.modTimeNs) ||
+            !readValue(content, offset, entry.inode) || !readValue(content, offset, entryCount)) {
+            break;
+        }
+        bool complete = true;
+        for (uint32_t j = 0; j < entryCount && complete; j++) {
+            uint8_t type = 0;
+            DirEntry item;
+            complete = readValue(content, offset, type) && readString(content, offset, item.name);
+            item.isFile = type == 1;
+            item.isDir = type == 2;
+            entry.entries.push_back(item);
+        }
+        if (!complete) {
+            break;
+        }
+        entry.verified = false;
+        directories[path] = std::move(entry);
+    }
+    return true;
+}
+
+bool DirectoryCache::save() {
+    std::lock_guard<std::mutex> lock(mutex);
+    
+    // 只保留本次用到的目录，删除的目录和不再扫描的目录不会一直留在缓存中
+    uint64_t used = 0;
+    for (const auto& item : directories) {
+        used += item.second.verified ? 1 : 0;
+    }
+    if ((!dirty && used == directories.size()) || filename.empty()) {
+        return true;
+    }
+    
+    std::string content(DIR_CACHE_MAGIC, 4);
+    appendValue(content, DIR_CACHE_VERSION);
+    appendValue(content, nowNs() - RACY_MARGIN_NS);
+    appendValue(content, used);
+    for (const auto& item : directories) {
+        if (!item.second.verified) {
+            continue;
+        }
+        appendValue(content, static_cast<uint32_t>(item.first.size()));
+        content += item.first;
+        appendValue(content, item.second.modTimeNs);
+        appendValue(content, item.second.inode);
+        appendValue(content, static_cast<uint32_t>(item.second.entries.size()));
+        for (const auto& entry : item.second.entries) {
+            appendValue(content, static_cast<uint8_t>(entry.isFile ? 1 : (entry.isDir ? 2 : 0)));
+            appendValue(content, static_cast<uint32_t>(entry.name.size()));
+            content += entry.name;
+        }
+    }
+    
+    std::string tempFile = filename + ".tmp";
+    std::ofstream out(tempFile, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "Warning: Cannot write directory cache: " << tempFile << std::endl;
+        return false;
+    }
+    out.write(content.data(), content.size());
+    out.close();
+    
+#ifdef _WIN32
+    std::remove(filename.c_str());
+#endif
+    if (std::rename(tempFile.c_str(), filename.c_str()) != 0) {
+        return false;
+    }
+    dirty = false;
+    return true;
+}
+
+bool DirectoryCache::find(const std::string& path, uint64_t modTimeNs, uint64_t inode,
+                          std::vector<DirEntry>& entries) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = directories.find(path);
+    if (it == directories.end()) {
+        return false;
+    }
+    const Entry& cached = it->second;
+    if (cached.modTimeNs != modTimeNs || cached.inode != inode ||
+        (!cached.verified && cached.modTimeNs >= savedAtNs)) {
+        return false;
+    }
+    it->second.verified = true;
+    entries = cached.entries;
+    return true;
+}
+
+void DirectoryCache::store(const std::string& path, uint64_t modTimeNs, uint64_t inode,
+                           const std::vector<DirEntry>& entries) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Entry& entry = directories[path];
+    entry.modTimeNs = modTimeNs;
+    entry.inode = inode;
+    entry.entries = entries;
+    entry.verified = true;
+    dirty = true;
+}
@@ -0,0 +1,52 @@
+#ifndef DIRCACHE_HPP
+#define DIRCACHE_HPP
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+
+// 目录中的一项
+struct DirEntry {
+    std::string name;
+    bool isDir;   // 目录（不包括指向目录的符号链接）
+    bool isFile;  // 普通文件或指向普通文件的符号链接
+};
+
+// 目录列表缓存
+// 在目录中增删或重命名文件会改变目录的修改时间，因此目录的修改时间（纳秒）和 inode
+// 都未变化时直接使用上次读取的列表，不再读取目录；缓存保存在构建目录中供之后的构建使用
+class DirectoryCache {
+public:
+    DirectoryCache();
+    
+    // 读取缓存文件，文件不存在时视为空缓存
+    bool load(const std::string& filename);
+    
+    // 缓存有变化时写回文件
+    bool save();
+    
+    // 目录没有变化时返回缓存的列表
+    bool find(const std::string& path, uint64_t modTimeNs, uint64_t inode, std::vector<DirEntry>& entries);
+    
+    // 记录重新读取的目录列表
+    void store(const std::string& path, uint64_t modTimeNs, uint64_t inode,
+               const std::vector<DirEntry>& entries);
+    
+private:
+    struct Entry {
+        uint64_t modTimeNs;
+        uint64_t inode;
+        std::vector<DirEntry> entries;
+        bool verified; // 本次运行中已确认
+    };
+    
+    std::string filename;
+    std::unordered_map<std::string, Entry> directories;
+    uint64_t savedAtNs;
+    bool dirty;
+    std::mutex mutex;
+};
+
+#endif // DIRCACHE_HPP
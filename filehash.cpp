@@ -0,0 +1,237 @@
+#include "filehash.hpp"
+#include "hash.hpp"
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <iterator>
+
+#ifdef _WIN32
+#include <sys/types.h>
+#include <sys/stat.h>
+#else
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// 文件格式：
+//   文件头: "BPFH" + uint32 版本号 + uint64 保存时间（纳秒）+ uint64 记录数
+//   记录:   uint32 路径长度 + 路径 + 修改时间、大小、inode、哈希（各 uint64）
+static const char HASH_CACHE_MAGIC[4] = {'B', 'P', 'F', 'H'};
+static const uint32_t HASH_CACHE_VERSION = 1;
+
+// 修改时间接近保存时间的记录不可信：文件可能在保存后又被修改，
+// 而文件系统时间戳的精度不足以区分。这些文件下次会重新计算哈希
+static const uint64_t RACY_MARGIN_NS = 2000000000ULL;
+
+static uint64_t nowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+template <typename T>
+static void appendValue(std::string& buffer, T value) {
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+static bool readValue(const std::string& buffer, size_t& offset, T& value) {
+    if (offset + sizeof(value) > buffer.size()) return false;
+    memcpy(&value, buffer.data() + offset, sizeof(value));
+    offset += sizeof(value);
+    return true;
+}
+
+FileHashCache::FileHashCache() : savedAtNs(0), dirty(false) {
+}
+
+bool FileHashCache::hashFile(const std::string& path, uint64_t size, uint64_t& hash) {
+    if (size == 0) {
+        hash = hash64(nullptr, 0);
+        return true;
+    }
+    
+#ifdef _WIN32
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    std::string content = buffer.str();
+#else
+    // 用 read 而不是 mmap：文件在读取信息后被截断（如编辑器保存）时，访问映射的末尾会产生 SIGBUS
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    std::string content(static_cast<size_t>(size) + 1, '\0');
+    size_t total = 0;
+    while (total < content.size()) {
+        ssize_t count = read(fd, &content[total], content.size() - total);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            break;
+        }
+        total += static_cast<size_t>(count);
+    }
+    close(fd);
+    content.resize(total);
+#endif
+    // 多读一个字节，文件变大或变小都能发现；此时哈希与记录的文件信息不对应
+    if (content.size() != size) {
+        return false;
+    }
+    hash = hash64(content.data(), content.size());
+    return true;
+}
+
+bool FileHashCache::hashContents(const std::string& path, uint64_t& hash) {
+    FileStat info = statPath(path);
+    return info.exists && hashFile(path, info.size, hash);
+}
+
+bool FileHashCache::load(const std::string& cacheFile) {
+    std::lock_guard<std::mutex> lock(mutex);
+    filename = cacheFile;
+    entries.clear();
+    savedAtNs = 0;
+    dirty = false;
+    
+    std::ifstream in(filename, std::ios::binary);
+    if (!in.is_open()) {
+        return true;
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    std::string content = buffer.str();
+    
+    size_t offset = 4;
+    uint32_t version = 0;
+    uint64_t count = 0;
+    if (content.size() < 4 || memcmp(content.data(), HASH_CACHE_MAGIC, 4) != 0 ||
+        !readValue(content, offset, version) || version != HASH_CACHE_VERSION ||
+        !readValue(content, offset, savedAtNs) || !readValue(content, offset, count)) {
+        std::cerr << "Warning: Ignoring invalid hash cache: " << filename << std::endl;
+        savedAtNs = 0;
+        return false;
+    }
+    
+    for (uint64_t i = 0; i < count; i++) {
+        uint32_t length;
+        Entry entry;
+        if (!readValue(content, offset, length) || offset + length > content.size()) {
+            break;
+        }
+        std::string path = content.substr(offset, length);
+        offset += length;
+        if (!readValue(content, offset, entry.modTimeNs) || !readValue(content, offset, entry.size) ||
+            !readValue(content, offset, entry.inode) || !readValue(content, offset, entry.hash)) {
+            break;
+        }
+        entry.verified = false;
+        entry.used = false;
+        entries[path] = entry;
+    }
+    return true;
+}
+
+bool FileHashCache::save() {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t usedCount = 0;
+    for (const auto& item : entries) {
+        usedCount += item.second.used ? 1 : 0;
+    }
+    if ((!dirty && usedCount == entries.size()) || filename.empty()) {
+        return true;
+    }
+    
+    // 本次运行没有查询的文件（已删除、改名或不再是输入）不写入，缓存不会无限增长
+    std::string content(HASH_CACHE_MAGIC, 4);
+    appendValue(content, HASH_CACHE_VERSION);
+    appendValue(content, nowNs() - RACY_MARGIN_NS);
+    appendValue(content, static_cast<uint64_t>(usedCount));
+    for (const auto& item : entries) {
+        if (!item.second.used) {
+            continue;
+        }
+        appendValue(content, static_cast<uint32_t>(item.first.size()));
+        content += item.first;
+        appendValue(content, item.second.modTimeNs);
+        appendValue(content, item.second.size);
+        appendValue(content, item.second.inode);
+        appendValue(content, item.second.hash);
+    }
+    
+    std::string tempFile = filename + ".tmp";
+    std::ofstream out(tempFile, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "Warning: Cannot write hash cache: " << tempFile << std::endl;
+        return false;
+    }
+    out.write(content.data(), content.size());
+    out.close();
+    
+#ifdef _WIN32
+    std::remove(filename.c_str());
+#endif
+    if (std::rename(tempFile.c_str(), filename.c_str()) != 0) {
+        std::remove(tempFile.c_str());
+        return false;
+    }
+    for (auto it = entries.begin(); it != entries.end();) {
+        it = it->second.used ? std::next(it) : entries.erase(it);
+    }
+    dirty = false;
+    return true;
+}
+
+bool FileHashCache::getHash(const std::string& path, uint64_t& hash) {
+    return getHash(path, statPath(path), hash);
+}
+
+bool FileHashCache::getHash(const std::string& path, const FileStat& info, uint64_t& hash) {
+    if (!info.exists) {
+        return false;
+    }
+    Entry current;
+    current.modTimeNs = info.modTimeNs;
+    current.size = info.size;
+    current.inode = info.inode;
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(path);
+        if (it != entries.end()) {
+            Entry& cached = it->second;
+            bool sameFile = cached.modTimeNs == current.modTimeNs && cached.size == current.size &&
+                            cached.inode == current.inode;
+            if (sameFile && (cached.verified || cached.modTimeNs < savedAtNs)) {
+                cached.used = true;
+                hash = cached.hash;
+                return true;
+            }
+        }
+    }
+    
+    // 修改时间、大小或 inode 有变化，重新计算内容哈希
+    if (!hashFile(path, current.size, current.hash)) {
+        return false;
+    }
+    current.verified = true;
+    current.used = true;
+    
+    // 即使哈希未变也写回，以更新保存时间，避免此文件每次都被重新计算
+    std::lock_guard<std::mutex> lock(mutex);
+    dirty = true;
+    entries[path] = current;
+    hash = current.hash;
+    return true;
+}
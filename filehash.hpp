@@ -0,0 +1,52 @@
+#ifndef FILEHASH_HPP
+#define FILEHASH_HPP
+
+#include "filestat.hpp"
+#include <string>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+
+// 文件内容哈希缓存
+// 文件的修改时间（纳秒）、大小和 inode 都未变化时直接使用缓存的哈希，
+// 否则重新读取文件计算哈希；缓存保存在构建目录中供之后的构建使用
+class FileHashCache {
+public:
+    FileHashCache();
+    
+    // 读取缓存文件，文件不存在时视为空缓存
+    bool load(const std::string& filename);
+    
+    // 缓存有变化时写回文件，只保留本次运行中用到的文件（已删除或改名的文件不再保留）
+    bool save();
+    
+    // 获取文件内容的哈希，文件不存在或无法读取时返回 false
+    bool getHash(const std::string& path, uint64_t& hash);
+    
+    // 同上，使用已经读取的文件信息（如快照中的信息），不再 stat
+    bool getHash(const std::string& path, const FileStat& info, uint64_t& hash);
+    
+    // 直接计算文件内容的哈希，不使用缓存
+    static bool hashContents(const std::string& path, uint64_t& hash);
+    
+private:
+    struct Entry {
+        uint64_t modTimeNs;
+        uint64_t size;
+        uint64_t inode;
+        uint64_t hash;
+        bool verified; // 本次运行中已确认，不写入文件
+        bool used;     // 本次运行中查询过，不写入文件
+    };
+    
+    std::string filename;
+    std::unordered_map<std::string, Entry> entries;
+    uint64_t savedAtNs;
+    bool dirty;
+    std::mutex mutex;
+    
+    // 读取文件计算哈希；文件大小与 size 不同（读取信息后又被修改）时返回 false
+    static bool hashFile(const std::string& path, uint64_t size, uint64_t& hash);
+};
+
+#endif // FILEHASH_HPP
@@ -0,0 +1,123 @@
+#include "filestat.hpp"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#ifdef _WIN32
+#include <sys/types.h>
+#include <sys/stat.h>
+#else
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <errno.h>
+#endif
+
+// 并行读取文件信息的线程数上限，以及每个线程至少处理的文件数（文件少时不创建线程）
+static const size_t MAX_STAT_THREADS = 16;
+static const size_t MIN_FILES_PER_THREAD = 256;
+
+#if defined(__linux__) && defined(STATX_BASIC_STATS)
+// 内核或容器的安全策略不支持 statx 时改用 stat
+static std::atomic<bool> statxUnavailable(false);
+#endif
+
+FileStat statPath(const std::string& path) {
+    FileStat result;
+#ifdef _WIN32
+    struct _stat info;
+    if (_stat(path.c_str(), &info) != 0) {
+        return result;
+    }
+    result.modTimeNs = static_cast<uint64_t>(info.st_mtime) * 1000000000ULL;
+    result.size = static_cast<uint64_t>(info.st_size);
+#else
+#if defined(__linux__) && defined(STATX_BASIC_STATS)
+    if (!statxUnavailable.load(std::memory_order_relaxed)) {
+        struct statx info;
+        if (statx(AT_FDCWD, path.c_str(), 0, STATX_MTIME | STATX_SIZE | STATX_INO, &info) == 0) {
+            result.exists = true;
+            result.modTimeNs = static_cast<uint64_t>(info.stx_mtime.tv_sec) * 1000000000ULL +
+                               static_cast<uint64_t>(info.stx_mtime.tv_nsec);
+            result.size = info.stx_size;
+            result.inode = info.stx_ino;
+            return result;
+        }
+        if (errno != ENOSYS && errno != EPERM) {
+            return result;
+        }
+        statxUnavailable = true;
+    }
+#endif
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+        return result;
+    }
+#ifdef __APPLE__
+    result.modTimeNs = static_cast<uint64_t>(info.st_mtimespec.tv_sec) * 1000000000ULL +
+                       static_cast<uint64_t>(info.st_mtimespec.tv_nsec);
+#else
+    result.modTimeNs = static_cast<uint64_t>(info.st_mtim.tv_sec) * 1000000000ULL +
+                       static_cast<uint64_t>(info.st_mtim.tv_nsec);
+#endif
+    result.size = static_cast<uint64_t>(info.st_size);
+    result.inode = static_cast<uint64_t>(info.st_ino);
+#endif
+    result.exists = true;
+    return result;
+}
+
+FileStat FileSnapshot::get(const std::string& path) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = files.find(path);
+        if (it != files.end()) {
+            return it->second;
+        }
+    }
+    
+    // 读取时不持有锁，其他线程可以同时查询；同一文件被重复读取时结果相同
+    FileStat info = statPath(path);
+    std::lock_guard<std::mutex> lock(mutex);
+    files[path] = info;
+    return info;
+}
+
+void FileSnapshot::prefetch(const std::vector<std::string>& paths) {
+    std::vector<const std::string*> missing;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& path : paths) {
+            if (!files.count(path)) {
+                missing.push_back(&path);
+            }
+        }
+    }
+    
+    // 各线程按顺序领取文件，结果写入各自的位置，最后一次性加入快照
+    std::vector<FileStat> results(missing.size());
+    std::atomic<size_t> next(0);
+    auto work = [&]() {
+        for (size_t i = next++; i < missing.size(); i = next++) {
+            results[i] = statPath(*missing[i]);
+        }
+    };
+    size_t threads = std::min(MAX_STAT_THREADS, missing.size() / MIN_FILES_PER_THREAD);
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < threads; i++) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t i = 0; i < missing.size(); i++) {
+        files.emplace(*missing[i], results[i]);
+    }
+}
+
+void FileSnapshot::invalidate(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    files.erase(path);
+}
@@ -0,0 +1,40 @@
+#ifndef FILESTAT_HPP
+#define FILESTAT_HPP
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+
+// 文件信息
+struct FileStat {
+    bool exists = false;
+    uint64_t modTimeNs = 0; // 修改时间（纳秒）
+    uint64_t size = 0;
+    uint64_t inode = 0;     // Windows 上为 0
+};
+
+// 读取文件信息（Linux 上使用只请求所需字段的 statx），文件不存在时 exists 为 false
+FileStat statPath(const std::string& path);
+
+// 文件信息快照
+// 每个路径在一次构建中只读取一次，不存在的文件同样记录；可在多个线程中使用。
+// 构建中改写的文件（目标文件、链接输出等）在改写后调用 invalidate
+class FileSnapshot {
+public:
+    // 获取文件信息，不在快照中时读取并记录
+    FileStat get(const std::string& path);
+    
+    // 用多个线程并行读取还不在快照中的文件，网络文件系统上每次 stat 的延迟较高时可以大幅缩短检查时间
+    void prefetch(const std::vector<std::string>& paths);
+    
+    // 文件发生变化，下次使用时重新读取
+    void invalidate(const std::string& path);
+    
+private:
+    std::unordered_map<std::string, FileStat> files;
+    std::mutex mutex;
+};
+
+#endif // FILESTAT_HPP
@@ -0,0 +1,197 @@
+#include "fsutil.hpp"
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cerrno>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <sys/utime.h>
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/ioctl.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <utime.h>
+#ifdef __linux__
+#include <linux/fs.h>
+#endif
+#endif
+
+bool createDirectories(const std::string& path) {
+    if (path.empty()) {
+        return true;
+    }
+    
+    size_t pos = 0;
+    while (true) {
+        pos = path.find_first_of("/\\", pos + 1);
+        std::string current = path.substr(0, pos);
+        if (!current.empty() && current.back() != ':') {
+#ifdef _WIN32
+            if (_mkdir(current.c_str()) != 0 && errno != EEXIST) {
+#else
+            if (mkdir(current.c_str(), 0755) != 0 && errno != EEXIST) {
+#endif
+                return false;
+            }
+        }
+        if (pos == std::string::npos) {
+            break;
+        }
+    }
+    return true;
+}
+
+static bool copyFileContents(const std::string& source, const std::string& dest) {
+    std::ifstream in(source, std::ios::binary);
+    if (!in.is_open()) {
+        return false;
+    }
+    std::ofstream out(dest, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        return false;
+    }
+    out << in.rdbuf();
+    out.close();
+    return !out.fail();
+}
+
+bool cloneFile(const std::string& source, const std::string& dest, bool allowHardLink) {
+    std::remove(dest.c_str());
+    
+#if defined(__linux__) && defined(FICLONE)
+    // 支持写时复制的文件系统（btrfs、xfs等）上共享数据块，不复制内容
+    int sourceFd = open(source.c_str(), O_RDONLY);
+    if (sourceFd >= 0) {
+        int destFd = open(dest.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (destFd >= 0) {
+            bool cloned = ioctl(destFd, FICLONE, sourceFd) == 0;
+            close(destFd);
+            close(sourceFd);
+            if (cloned) {
+                return true;
+            }
+            std::remove(dest.c_str());
+        } else {
+            close(sourceFd);
+        }
+    }
+#endif
+    
+#ifdef _WIN32
+    if (allowHardLink && CreateHardLinkA(dest.c_str(), source.c_str(), nullptr)) {
+        return true;
+    }
+#else
+    if (allowHardLink && link(source.c_str(), dest.c_str()) == 0) {
+        return true;
+    }
+#endif
+    
+    return copyFileContents(source, dest);
+}
+
+bool touchFile(const std::string& path) {
+#ifdef _WIN32
+    return _utime(path.c_str(), nullptr) == 0;
+#else
+    return utime(path.c_str(), nullptr) == 0;
+#endif
+}
+
+std::string absolutePath(const std::string& path) {
+    if (!path.empty() && (path[0] == '/' || path[0] == '\\' ||
+                          (path.size() > 1 && path[1] == ':'))) {
+        return path;
+    }
+    
+    char buffer[4096];
+#ifdef _WIN32
+    if (!_getcwd(buffer, sizeof(buffer))) {
+#else
+    if (!getcwd(buffer, sizeof(buffer))) {
+#endif
+        return path;
+    }
+    
+    std::string relative = path;
+    while (relative.compare(0, 2, "./") == 0) {
+        relative = relative.substr(2);
+    }
+    return std::string(buffer) + "/" + relative;
+}
+
+bool writeFileIfChanged(const std::string& path, const std::string& content) {
+    std::ifstream in(path, std::ios::binary);
+    if (in.is_open()) {
+        std::stringstream buffer;
+        buffer << in.rdbuf();
+        if (buffer.str() == content) {
+            return true;
+        }
+    }
+    in.close();
+    
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        return false;
+    }
+    out << content;
+    out.close();
+    return !out.fail();
+}
+
+bool removeAll(const std::string& path) {
+#ifdef _WIN32
+    DWORD attributes = GetFileAttributesA(path.c_str());
+    if (attributes == INVALID_FILE_ATTRIBUTES) {
+        return true;
+    }
+    if (!(attributes & FILE_ATTRIBUTE_DIRECTORY) || (attributes & FILE_ATTRIBUTE_REPARSE_POINT)) {
+        SetFileAttributesA(path.c_str(), FILE_ATTRIBUTE_NORMAL);
+        return (attributes & FILE_ATTRIBUTE_DIRECTORY) ? RemoveDirectoryA(path.c_str()) != 0
+                                                       : DeleteFileA(path.c_str()) != 0;
+    }
+    
+    bool ok = true;
+    WIN32_FIND_DATAA findData;
+    HANDLE hFind = FindFirstFileA((path + "\\*").c_str(), &findData);
+    if (hFind != INVALID_HANDLE_VALUE) {
+        do {
+            std::string name = findData.cFileName;
+            if (name != "." && name != "..") {
+                ok = removeAll(path + "\\" + name) && ok;
+            }
+        } while (FindNextFileA(hFind, &findData));
+        FindClose(hFind);
+    }
+    return RemoveDirectoryA(path.c_str()) != 0 && ok;
+#else
+    // 使用 lstat：符号链接只删除链接本身，不进入其指向的目录
+    struct stat info;
+    if (lstat(path.c_str(), &info) != 0) {
+        return errno == ENOENT;
+    }
+    if (!S_ISDIR(info.st_mode)) {
+        return unlink(path.c_str()) == 0;
+    }
+    
+    bool ok = true;
+    DIR* dir = opendir(path.c_str());
+    if (dir) {
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != nullptr) {
+            std::string name = entry->d_name;
+            if (name != "." && name != "..") {
+                ok = removeAll(path + "/" + name) && ok;
+            }
+        }
+        closedir(dir);
+    }
+    return rmdir(path.c_str()) == 0 && ok;
+#endif
+}
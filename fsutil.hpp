@@ -0,0 +1,24 @@
+#ifndef FSUTIL_HPP
+#define FSUTIL_HPP
+
+#include <string>
+
+// 逐级创建目录（类似 mkdir -p）
+bool createDirectories(const std::string& path);
+
+// 复制文件，依次尝试 reflink、硬链接（allowHardLink 为 true 时）和普通复制
+bool cloneFile(const std::string& source, const std::string& dest, bool allowHardLink);
+
+// 把文件的修改时间设为当前时间
+bool touchFile(const std::string& path);
+
+// 将相对路径转换为基于当前目录的绝对路径
+std::string absolutePath(const std::string& path);
+
+// 内容不同时才写入文件，内容相同时保留原来的修改时间
+bool writeFileIfChanged(const std::string& path, const std::string& content);
+
+// 递归删除文件或目录（类似 rm -rf），路径不存在时也返回 true
+bool removeAll(const std::string& path);
+
+#endif // FSUTIL_HPP
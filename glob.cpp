@@ -0,0 +1,441 @@
+#include "glob.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// 遍历目录树的最大线程数；目录遍历主要受系统调用延迟限制，更多线程收益很小
+static const unsigned MAX_WALK_THREADS = 8;
+
+// 等待遍历的目录达到此数量时才启动其他线程，小目录树由当前线程遍历，不创建线程
+static const size_t MIN_PARALLEL_DIRS = 32;
+
+// 同时保持打开、等待遍历的目录数上限，超出后记录路径，轮到时再按路径打开
+static const int MAX_OPEN_DIRS = 256;
+
+bool hasGlobChars(const std::string& pattern) {
+    return pattern.find_first_of("*?[") != std::string::npos;
+}
+
+// 按 / 拆分路径，忽略空的部分和 "."
+static std::vector<std::string> splitPath(const std::string& path) {
+    std::vector<std::string> parts;
+    size_t start = 0;
+    while (start <= path.size()) {
+        size_t slash = path.find('/', start);
+        if (slash == std::string::npos) {
+            slash = path.size();
+        }
+        std::string part = path.substr(start, slash - start);
+        if (!part.empty() && part != ".") {
+            parts.push_back(part);
+        }
+        start = slash + 1;
+    }
+    return parts;
+}
+
+// 匹配 pattern[pos] 开始的一个字符（普通字符、? 或 [...]），成功时 next 为下一个模式字符的位置
+static bool matchChar(const std::string& pattern, size_t pos, char c, size_t& next) {
+    if (pattern[pos] == '?') {
+        next = pos + 1;
+        return true;
+    }
+    if (pattern[pos] == '[') {
+        size_t i = pos + 1;
+        bool negate = i < pattern.size() && (pattern[i] == '!' || pattern[i] == '^');
+        if (negate) {
+            i++;
+        }
+        // 紧跟在 [ 或 [! 之后的 ] 是普通字符
+        size_t close = pattern.find(']', i + 1);
+        if (close != std::string::npos) {
+            bool matched = false;
+            for (; i < close; i++) {
+                if (i + 2 < close && pattern[i + 1] == '-') {
+                    matched = matched || (c >= pattern[i] && c <= pattern[i + 2]);
+                    i += 2;
+                } else {
+                    matched = matched || c == pattern[i];
+                }
+            }
+            next = close + 1;
+            return matched != negate;
+        }
+        // 没有对应的 ]，按普通字符处理
+    }
+    next = pos + 1;
+    return pattern[pos] == c;
+}
+
+// 匹配路径中的一段（不含 /）
+static bool matchSegment(const std::string& pattern, const std::string& name) {
+    if (!name.empty() && name[0] == '.' && (pattern.empty() || pattern[0] != '.')) {
+        return false;
+    }
+    
+    size_t p = 0, s = 0;
+    size_t starPattern = std::string::npos, starName = 0;
+    while (s < name.size()) {
+        size_t next;
+        if (p < pattern.size() && pattern[p] == '*') {
+            starPattern = p++;
+            starName = s;
+        } else if (p < pattern.size() && matchChar(pattern, p, name[s], next)) {
+            p = next;
+            s++;
+        } else if (starPattern != std::string::npos) {
+            // 回到上一个 *，让它多匹配一个字符
+            p = starPattern + 1;
+            s = ++starName;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*') {
+        p++;
+    }
+    return p == pattern.size();
+}
+
+// 模式的各段 pattern[i..] 是否匹配路径的各段 path[j..]
+static bool matchParts(const std::vector<std::string>& pattern, size_t i,
+                       const std::vector<std::string>& path, size_t j) {
+    if (i == pattern.size()) {
+        return j == path.size();
+    }
+    if (pattern[i] == "**") {
+        // ** 依次尝试匹配 0 层、1 层……目录，不进入以 . 开头的目录
+        for (size_t k = j; k <= path.size(); k++) {
+            if (matchParts(pattern, i + 1, path, k)) {
+                return true;
+            }
+            if (k < path.size() && path[k][0] == '.') {
+                return false;
+            }
+        }
+        return false;
+    }
+    return j < path.size() && matchSegment(pattern[i], path[j]) && matchParts(pattern, i + 1, path, j + 1);
+}
+
+// 路径为 dir 的目录之下是否可能有与模式匹配的文件
+static bool canMatchBelow(const std::vector<std::string>& pattern, size_t i,
+                          const std::vector<std::string>& dir, size_t j) {
+    if (i == pattern.size()) {
+        return false;
+    }
+    if (pattern[i] == "**") {
+        // ** 可以匹配剩下的所有目录，除非其中有以 . 开头的目录
+        for (size_t k = j; k <= dir.size(); k++) {
+            if (k == dir.size() || canMatchBelow(pattern, i + 1, dir, k)) {
+                return true;
+            }
+            if (dir[k][0] == '.') {
+                return false;
+            }
+        }
+        return false;
+    }
+    if (j == dir.size()) {
+        return true;
+    }
+    return matchSegment(pattern[i], dir[j]) && canMatchBelow(pattern, i + 1, dir, j + 1);
+}
+
+bool matchGlob(const std::string& pattern, const std::string& path) {
+    return matchParts(splitPath(pattern), 0, splitPath(path), 0);
+}
+
+bool isExcludedPath(const std::string& path, const std::vector<std::string>& excludes) {
+    if (excludes.empty()) {
+        return false;
+    }
+    std::vector<std::string> parts = splitPath(path);
+    for (const auto& exclude : excludes) {
+        std::vector<std::string> pattern = splitPath(exclude);
+        for (size_t length = 1; length <= parts.size(); length++) {
+            std::vector<std::string> prefix(parts.begin(), parts.begin() + length);
+            if (matchParts(pattern, 0, prefix, 0)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// 等待遍历的目录
+struct PendingDir {
+    std::string path;                // 输出中使用的路径
+    std::vector<std::string> parts;  // 相对于遍历起点的各段
+    int fd;                          // 已打开的目录，为 -1 时按 path 打开
+};
+
+// 多个线程从共享队列中取出目录遍历，发现的子目录放回队列
+class TreeWalk {
+public:
+    TreeWalk(const std::vector<std::string>& pattern, const std::vector<std::string>& excludes,
+             DirectoryCache* cache)
+        : pattern(pattern), excludes(excludes), cache(cache), active(0), openDirs(0), listed(0) {
+    }
+    
+    // 实际读取的目录数（其余目录使用缓存的列表）
+    size_t listedDirs() const { return listed; }
+    
+    std::vector<std::string> run(const std::string& root) {
+        queue.push_back(PendingDir{root, std::vector<std::string>(), -1});
+        
+        // 先在当前线程遍历（此时没有其他线程，不需要加锁），目录树足够大时再并行
+        while (!queue.empty() && queue.size() < MIN_PARALLEL_DIRS) {
+            PendingDir dir = std::move(queue.front());
+            queue.pop_front();
+            std::vector<PendingDir> subdirs;
+            scan(dir, results, subdirs);
+            for (auto& subdir : subdirs) {
+                queue.push_back(std::move(subdir));
+            }
+        }
+        if (queue.empty()) {
+            std::sort(results.begin(), results.end());
+            return results;
+        }
+        
+        unsigned threads = std::max(1u, std::min(MAX_WALK_THREADS, std::thread::hardware_concurrency()));
+        std::vector<std::thread> workers;
+        for (unsigned i = 1; i < threads; i++) {
+            workers.emplace_back(&TreeWalk::work, this);
+        }
+        work();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        
+        std::sort(results.begin(), results.end());
+        return results;
+    }
+    
+private:
+    const std::vector<std::string>& pattern;
+    const std::vector<std::string>& excludes;
+    DirectoryCache* cache;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<PendingDir> queue;
+    int active;
+    std::atomic<int> openDirs;
+    std::atomic<size_t> listed;
+    std::vector<std::string> results;
+    
+    void work() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            changed.wait(lock, [this]() { return !queue.empty() || active == 0; });
+            if (queue.empty()) {
+                // 队列为空且没有线程在遍历，不会再有新的目录
+                changed.notify_all();
+                return;
+            }
+            PendingDir dir = std::move(queue.front());
+            queue.pop_front();
+            active++;
+            lock.unlock();
+            
+            std::vector<std::string> found;
+            std::vector<PendingDir> subdirs;
+            scan(dir, found, subdirs);
+            
+            lock.lock();
+            results.insert(results.end(), found.begin(), found.end());
+            for (auto& subdir : subdirs) {
+                queue.push_back(std::move(subdir));
+            }
+            active--;
+            changed.notify_all();
+        }
+    }
+    
+    std::string childPath(const PendingDir& dir, const std::string& name) {
+        return dir.path == "." ? name : (dir.path == "/" ? "/" + name : dir.path + "/" + name);
+    }
+    
+#ifdef _WIN32
+    void scan(const PendingDir& dir, std::vector<std::string>& found, std::vector<PendingDir>& subdirs) {
+        struct _stat info;
+        bool known = _stat(dir.path.c_str(), &info) == 0;
+        uint64_t modTimeNs = static_cast<uint64_t>(info.st_mtime) * 1000000000ULL;
+        std::vector<DirEntry> entries;
+        if (!known || !cache || !cache->find(dir.path, modTimeNs, 0, entries)) {
+            WIN32_FIND_DATA findData;
+            HANDLE hFind = FindFirstFile((dir.path + "\\*").c_str(), &findData);
+            if (hFind == INVALID_HANDLE_VALUE) {
+                return;
+            }
+            do {
+                DirEntry entry;
+                entry.name = findData.cFileName;
+                if (entry.name == "." || entry.name == "..") {
+                    continue;
+                }
+                bool isDir = (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+                bool isLink = (findData.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) != 0;
+                entry.isDir = isDir && !isLink;
+                entry.isFile = !isDir;
+                entries.push_back(entry);
+            } while (FindNextFile(hFind, &findData));
+            FindClose(hFind);
+            
+            listed++;
+            if (known && cache) {
+                cache->store(dir.path, modTimeNs, 0, entries);
+            }
+        }
+        
+        for (const auto& entry : entries) {
+            visit(dir, entry, found, subdirs, -1);
+        }
+    }
+#else
+    void scan(const PendingDir& dir, std::vector<std::string>& found, std::vector<PendingDir>& subdirs) {
+        int fd = dir.fd;
+        if (fd >= 0) {
+            openDirs--;
+        } else {
+            fd = open(dir.path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            if (fd < 0) {
+                return;
+            }
+        }
+    
+        // 目录的修改时间和 inode 没有变化时使用缓存的列表，不读取目录
+        struct stat info;
+        bool known = fstat(fd, &info) == 0;
+#ifdef __APPLE__
+        uint64_t modTimeNs = static_cast<uint64_t>(info.st_mtimespec.tv_sec) * 1000000000ULL +
+                             static_cast<uint64_t>(info.st_mtimespec.tv_nsec);
+#else
+        uint64_t modTimeNs = static_cast<uint64_t>(info.st_mtim.tv_sec) * 1000000000ULL +
+                             static_cast<uint64_t>(info.st_mtim.tv_nsec);
+#endif
+        uint64_t inode = static_cast<uint64_t>(info.st_ino);
+        std::vector<DirEntry> entries;
+        if (!known || !cache || !cache->find(dir.path, modTimeNs, inode, entries)) {
+            if (!readEntries(fd, entries)) {
+                close(fd);
+                return;
+            }
+            listed++;
+            if (known && cache) {
+                cache->store(dir.path, modTimeNs, inode, entries);
+            }
+        }
+    
+        for (const auto& entry : entries) {
+            visit(dir, entry, found, subdirs, fd);
+        }
+        close(fd);
+    }
+    
+    // 读取目录中的所有项；fd 保持打开，之后用于打开子目录
+    static bool readEntries(int fd, std::vector<DirEntry>& entries) {
+        int copy = dup(fd);
+        DIR* handle = copy >= 0 ? fdopendir(copy) : nullptr;
+        if (!handle) {
+            if (copy >= 0) {
+                close(copy);
+            }
+            return false;
+        }
+    
+        struct dirent* item;
+        while ((item = readdir(handle)) != nullptr) {
+            DirEntry entry;
+            entry.name = item->d_name;
+            if (entry.name == "." || entry.name == "..") {
+                continue;
+            }
+    
+            // 只有文件系统不提供类型或者是符号链接时才 stat；不进入指向目录的符号链接，避免循环
+            entry.isDir = item->d_type == DT_DIR;
+            entry.isFile = item->d_type == DT_REG;
+            if (item->d_type == DT_UNKNOWN || item->d_type == DT_LNK) {
+                struct stat info;
+                if (fstatat(fd, item->d_name, &info, 0) == 0) {
+                    entry.isFile = S_ISREG(info.st_mode);
+                    entry.isDir = item->d_type == DT_UNKNOWN && S_ISDIR(info.st_mode);
+                }
+            }
+            entries.push_back(entry);
+        }
+        closedir(handle);
+        return true;
+    }
+#endif
+    
+    void visit(const PendingDir& dir, const DirEntry& entry,
+               std::vector<std::string>& found, std::vector<PendingDir>& subdirs, int parentFd) {
+        const std::string& name = entry.name;
+        std::vector<std::string> parts = dir.parts;
+        parts.push_back(name);
+        
+        if (entry.isFile) {
+            std::string path = childPath(dir, name);
+            if (matchParts(pattern, 0, parts, 0) && !isExcludedPath(path, excludes)) {
+                found.push_back(path);
+            }
+        } else if (entry.isDir && canMatchBelow(pattern, 0, parts, 0)) {
+            std::string path = childPath(dir, name);
+            if (isExcludedPath(path, excludes)) {
+                return;
+            }
+            
+            // 相对于已打开的父目录打开子目录，不再从头解析路径
+            int fd = -1;
+#ifndef _WIN32
+            if (parentFd >= 0 && openDirs < MAX_OPEN_DIRS) {
+                fd = openat(parentFd, name.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+                if (fd >= 0) {
+                    openDirs++;
+                }
+            }
+#else
+            (void)parentFd;
+#endif
+            subdirs.push_back(PendingDir{path, parts, fd});
+        }
+    }
+};
+
+
+std::vector<std::string> globFiles(const std::string& pattern, const std::vector<std::string>& excludes,
+                                   DirectoryCache* cache, size_t* listedDirs) {
+    // 不含通配符的前缀目录作为遍历起点
+    std::vector<std::string> parts = splitPath(pattern);
+    std::string root = !pattern.empty() && pattern[0] == '/' ? "/" : ".";
+    size_t literal = 0;
+    while (literal + 1 < parts.size() && !hasGlobChars(parts[literal])) {
+        root = root == "." ? parts[literal] : (root == "/" ? "/" + parts[literal] : root + "/" + parts[literal]);
+        literal++;
+    }
+    
+    std::vector<std::string> rest(parts.begin() + literal, parts.end());
+    if (isExcludedPath(root, excludes)) {
+        return std::vector<std::string>();
+    }
+    TreeWalk walk(rest, excludes, cache);
+    std::vector<std::string> files = walk.run(root);
+    if (listedDirs) {
+        *listedDirs = walk.listedDirs();
+    }
+    return files;
+}
@@ -0,0 +1,27 @@
+#ifndef GLOB_HPP
+#define GLOB_HPP
+
+#include "dircache.hpp"
+#include <string>
+#include <vector>
+
+// 路径模式：* 和 ? 匹配除 / 以外的任意字符，[abc]、[a-z]、[!a-z] 匹配一个字符，
+// 单独的 ** 匹配任意层（包括 0 层）目录；* 和 ** 不匹配以 . 开头的文件和目录
+
+// 是否包含通配符
+bool hasGlobChars(const std::string& pattern);
+
+// 路径是否与模式匹配
+bool matchGlob(const std::string& pattern, const std::string& path);
+
+// 路径是否被排除：与某个排除模式匹配，或位于某个被排除的目录之下
+bool isExcludedPath(const std::string& path, const std::vector<std::string>& excludes);
+
+// 查找与模式匹配的所有普通文件，按路径排序返回
+// 从模式中不含通配符的前缀目录开始遍历目录树（openat + d_type，每个条目不额外 stat），目录较多时多线程并行，
+// 被排除的目录不进入。cache 不为空时修改时间和 inode 未变的目录使用缓存的列表，
+// listedDirs 不为空时返回实际读取的目录数
+std::vector<std::string> globFiles(const std::string& pattern, const std::vector<std::string>& excludes,
+                                   DirectoryCache* cache = nullptr, size_t* listedDirs = nullptr);
+
+#endif // GLOB_HPP
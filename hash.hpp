@@ -0,0 +1,21 @@
+#ifndef HASH_HPP
+#define HASH_HPP
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// 64位非加密哈希（XXH64算法）
+uint64_t hash64(const void* data, size_t length, uint64_t seed = 0);
+
+// 计算字符串的哈希
+inline uint64_t hashString(const std::string& str, uint64_t seed = 0) {
+    return hash64(str.data(), str.size(), seed);
+}
+
+// 将一个整数混入已有哈希值
+inline uint64_t hashCombine(uint64_t hash, uint64_t value) {
+    return hash64(&value, sizeof(value), hash);
+}
+
+#endif // HASH_HPP
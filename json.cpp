@@ -0,0 +1,339 @@
+#include "json.hpp"
+#include <cstdlib>
+#include <cstring>
+
+// 嵌套层数上限，防止异常输入导致栈溢出
+static const int MAX_DEPTH = 256;
+
+JsonValue::JsonValue()
+    : valueType(Null), boolValue(false), numberValue(0), valueLine(0), valueColumn(0) {
+}
+
+const JsonValue* JsonValue::find(const std::string& key) const {
+    for (auto it = fields.rbegin(); it != fields.rend(); ++it) {
+        if (it->first == key) {
+            return &it->second;
+        }
+    }
+    return nullptr;
+}
+
+const char* JsonValue::typeName(Type type) {
+    switch (type) {
+        case Null: return "null";
+        case Bool: return "boolean";
+        case Number: return "number";
+        case String: return "string";
+        case Array: return "array";
+        case Object: return "object";
+    }
+    return "unknown";
+}
+
+JsonParser::JsonParser(const char* data, size_t size)
+    : pos(data), end(data + size), line(1), lineStart(data), depth(0) {
+}
+
+bool JsonParser::parse(JsonValue& root) {
+    // 跳过 UTF-8 BOM
+    if (end - pos >= 3 && memcmp(pos, "\xEF\xBB\xBF", 3) == 0) {
+        pos += 3;
+        lineStart = pos;
+    }
+    
+    skipWhitespace();
+    if (!parseValue(root)) {
+        return false;
+    }
+    skipWhitespace();
+    if (pos != end) {
+        return fail("Unexpected content after the end of the document");
+    }
+    return true;
+}
+
+bool JsonParser::fail(const std::string& message) {
+    if (errorMessage.empty()) {
+        errorMessage = std::to_string(line) + ":" + std::to_string(column()) + ": " + message;
+    }
+    return false;
+}
+
+void JsonParser::skipWhitespace() {
+    while (pos < end) {
+        char c = *pos;
+        if (c == '\n') {
+            line++;
+            lineStart = pos + 1;
+        } else if (c != ' ' && c != '\t' && c != '\r') {
+            return;
+        }
+        pos++;
+    }
+}
+
+bool JsonParser::parseValue(JsonValue& value) {
+    if (pos == end) {
+        return fail("Unexpected end of file");
+    }
+    
+    value.valueLine = line;
+    value.valueColumn = column();
+    switch (*pos) {
+        case '{':
+            return parseObject(value);
+        case '[':
+            return parseArray(value);
+        case '"':
+            value.valueType = JsonValue::String;
+            return parseString(value.stringValue);
+        case 't':
+            return parseLiteral("true", value);
+        case 'f':
+            return parseLiteral("false", value);
+        case 'n':
+            return parseLiteral("null", value);
+        default:
+            if (*pos == '-' || (*pos >= '0' && *pos <= '9')) {
+                return parseNumber(value);
+            }
+            return fail(std::string("Unexpected character '") + *pos + "'");
+    }
+}
+
+bool JsonParser::parseObject(JsonValue& value) {
+    if (++depth > MAX_DEPTH) {
+        return fail("Nesting too deep");
+    }
+    value.valueType = JsonValue::Object;
+    pos++;
+    
+    skipWhitespace();
+    if (pos < end && *pos == '}') {
+        pos++;
+        depth--;
+        return true;
+    }
+    
+    while (true) {
+        if (pos == end || *pos != '"') {
+            return fail("Expected a field name in double quotes");
+        }
+        std::string key;
+        if (!parseString(key)) {
+            return false;
+        }
+        
+        skipWhitespace();
+        if (pos == end || *pos != ':') {
+            return fail("Expected ':' after field name \"" + key + "\"");
+        }
+        pos++;
+        skipWhitespace();
+        
+        value.fields.emplace_back(std::move(key), JsonValue());
+        if (!parseValue(value.fields.back().second)) {
+            return false;
+        }
+        
+        skipWhitespace();
+        if (pos < end && *pos == ',') {
+            pos++;
+            skipWhitespace();
+            continue;
+        }
+        if (pos < end && *pos == '}') {
+            pos++;
+            depth--;
+            return true;
+        }
+        return fail("Expected ',' or '}' in object");
+    }
+}
+
+bool JsonParser::parseArray(JsonValue& value) {
+    if (++depth > MAX_DEPTH) {
+        return fail("Nesting too deep");
+    }
+    value.valueType = JsonValue::Array;
+    pos++;
+    
+    skipWhitespace();
+    if (pos < end && *pos == ']') {
+        pos++;
+        depth--;
+        return true;
+    }
+    
+    while (true) {
+        value.elements.emplace_back();
+        if (!parseValue(value.elements.back())) {
+            return false;
+        }
+        
+        skipWhitespace();
+        if (pos < end && *pos == ',') {
+            pos++;
+            skipWhitespace();
+            continue;
+        }
+        if (pos < end && *pos == ']') {
+            pos++;
+            depth--;
+            return true;
+        }
+        return fail("Expected ',' or ']' in array");
+    }
+}
+
+bool JsonParser::parseHex4(unsigned& code) {
+    if (end - pos < 4) {
+        return fail("Incomplete \\u escape");
+    }
+    code = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = *pos++;
+        code <<= 4;
+        if (c >= '0' && c <= '9') code |= c - '0';
+        else if (c >= 'a' && c <= 'f') code |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') code |= c - 'A' + 10;
+        else return fail("Invalid hex digit in \\u escape");
+    }
+    return true;
+}
+
+static void appendUtf8(std::string& out, unsigned code) {
+    if (code < 0x80) {
+        out += static_cast<char>(code);
+    } else if (code < 0x800) {
+        out += static_cast<char>(0xC0 | (code >> 6));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    } else if (code < 0x10000) {
+        out += static_cast<char>(0xE0 | (code >> 12));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (code >> 18));
+        out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    }
+}
+
+bool JsonParser::parseString(std::string& value) {
+    pos++;
+    while (true) {
+        // 没有转义的部分整段复制
+        const char* run = pos;
+        while (pos < end && *pos != '"' && *pos != '\\' && static_cast<unsigned char>(*pos) >= 0x20) {
+            pos++;
+        }
+        value.append(run, pos);
+        
+        if (pos == end) {
+            return fail("Unterminated string");
+        }
+        if (*pos == '"') {
+            pos++;
+            return true;
+        }
+        if (*pos != '\\') {
+            return fail("Control character in string (use \\n, \\t, ...)");
+        }
+        
+        pos++;
+        if (pos == end) {
+            return fail("Unterminated string");
+        }
+        char escape = *pos++;
+        switch (escape) {
+            case '"': value += '"'; break;
+            case '\\': value += '\\'; break;
+            case '/': value += '/'; break;
+            case 'b': value += '\b'; break;
+            case 'f': value += '\f'; break;
+            case 'n': value += '\n'; break;
+            case 'r': value += '\r'; break;
+            case 't': value += '\t'; break;
+            case 'u': {
+                unsigned code;
+                if (!parseHex4(code)) {
+                    return false;
+                }
+                // UTF-16 代理对
+                if (code >= 0xD800 && code <= 0xDBFF) {
+                    unsigned low;
+                    if (end - pos < 2 || pos[0] != '\\' || pos[1] != 'u') {
+                        return fail("Unpaired surrogate in \\u escape");
+                    }
+                    pos += 2;
+                    if (!parseHex4(low)) {
+                        return false;
+                    }
+                    if (low < 0xDC00 || low > 0xDFFF) {
+                        return fail("Unpaired surrogate in \\u escape");
+                    }
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                } else if (code >= 0xDC00 && code <= 0xDFFF) {
+                    return fail("Unpaired surrogate in \\u escape");
+                }
+                appendUtf8(value, code);
+                break;
+            }
+            default:
+                pos--;
+                return fail(std::string("Invalid escape '\\") + escape + "'");
+        }
+    }
+}
+
+bool JsonParser::parseNumber(JsonValue& value) {
+    const char* start = pos;
+    if (*pos == '-') {
+        pos++;
+    }
+    if (pos == end || *pos < '0' || *pos > '9') {
+        return fail("Invalid number");
+    }
+    if (*pos == '0') {
+        pos++;
+    } else {
+        while (pos < end && *pos >= '0' && *pos <= '9') pos++;
+    }
+    if (pos < end && *pos == '.') {
+        pos++;
+        if (pos == end || *pos < '0' || *pos > '9') {
+            return fail("Invalid number");
+        }
+        while (pos < end && *pos >= '0' && *pos <= '9') pos++;
+    }
+    if (pos < end && (*pos == 'e' || *pos == 'E')) {
+        pos++;
+        if (pos < end && (*pos == '+' || *pos == '-')) pos++;
+        if (pos == end || *pos < '0' || *pos > '9') {
+            return fail("Invalid number");
+        }
+        while (pos < end && *pos >= '0' && *pos <= '9') pos++;
+    }
+    
+    // 输入不一定以 '\0' 结尾，复制后再转换
+    value.valueType = JsonValue::Number;
+    value.numberValue = std::strtod(std::string(start, pos).c_str(), nullptr);
+    return true;
+}
+
+bool JsonParser::parseLiteral(const char* literal, JsonValue& value) {
+    size_t length = strlen(literal);
+    if (static_cast<size_t>(end - pos) < length || memcmp(pos, literal, length) != 0) {
+        return fail("Invalid literal (expected true, false or null)");
+    }
+    pos += length;
+    
+    if (literal[0] == 'n') {
+        value.valueType = JsonValue::Null;
+    } else {
+        value.valueType = JsonValue::Bool;
+        value.boolValue = literal[0] == 't';
+    }
+    return true;
+}
@@ -0,0 +1,95 @@
+#ifndef JSON_HPP
+#define JSON_HPP
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstddef>
+
+// JSON 值（配置文件解析后的树）
+// 每个值记录它在文件中的行号和列号，读取配置时可以指出出错的位置
+class JsonValue {
+public:
+    enum Type { Null, Bool, Number, String, Array, Object };
+    
+    JsonValue();
+    
+    Type type() const { return valueType; }
+    bool isNull() const { return valueType == Null; }
+    bool isBool() const { return valueType == Bool; }
+    bool isNumber() const { return valueType == Number; }
+    bool isString() const { return valueType == String; }
+    bool isArray() const { return valueType == Array; }
+    bool isObject() const { return valueType == Object; }
+    
+    bool asBool() const { return boolValue; }
+    double asNumber() const { return numberValue; }
+    const std::string& asString() const { return stringValue; }
+    
+    // 数组的元素
+    const std::vector<JsonValue>& items() const { return elements; }
+    
+    // 对象的字段，保持文件中的顺序
+    const std::vector<std::pair<std::string, JsonValue>>& members() const { return fields; }
+    
+    // 查找对象的字段，不存在时返回 nullptr；同名字段以最后一个为准
+    const JsonValue* find(const std::string& key) const;
+    
+    // 类型名称，用于错误信息
+    static const char* typeName(Type type);
+    
+    size_t line() const { return valueLine; }
+    size_t column() const { return valueColumn; }
+    
+private:
+    friend class JsonParser;
+    
+    Type valueType;
+    bool boolValue;
+    double numberValue;
+    std::string stringValue;
+    std::vector<JsonValue> elements;
+    std::vector<std::pair<std::string, JsonValue>> fields;
+    size_t valueLine;
+    size_t valueColumn;
+};
+
+// 单遍 JSON 解析器：按顺序读取一次输入，直接构建 JsonValue 树
+class JsonParser {
+public:
+    // data 在解析期间必须保持有效（可以是映射的文件内容）
+    JsonParser(const char* data, size_t size);
+    
+    // 解析整个文档，失败时 error() 返回带行号和列号的错误说明
+    bool parse(JsonValue& root);
+    
+    const std::string& error() const { return errorMessage; }
+    
+private:
+    const char* pos;
+    const char* end;
+    size_t line;
+    const char* lineStart;
+    int depth;
+    std::string errorMessage;
+    
+    bool parseValue(JsonValue& value);
+    bool parseObject(JsonValue& value);
+    bool parseArray(JsonValue& value);
+    bool parseString(std::string& value);
+    bool parseNumber(JsonValue& value);
+    bool parseLiteral(const char* literal, JsonValue& value);
+    
+    // 跳过空白，同时记录行号
+    void skipWhitespace();
+    
+    // 读取 4 位十六进制数字（\u 转义）
+    bool parseHex4(unsigned& code);
+    
+    size_t column() const { return static_cast<size_t>(pos - lineStart) + 1; }
+    
+    // 在当前位置报告错误，总是返回 false
+    bool fail(const std::string& message);
+};
+
+#endif // JSON_HPP
@@ -1,7 +1,11 @@
 #include "config.hpp"
-#include "compiler.hpp"
+#include "project.hpp"
+#include "trace.hpp"
+#include "watch.hpp"
+#include "remote.hpp"
 #include <iostream>
 #include <string>
+#include <cstdlib>
 
 void printUsage(const char* programName) {
     std::cout << "Usage: " << programName << " [options] [config_file]" << std::endl;
@@ -10,14 +14,25 @@ void printUsage(const char* programName) {
     std::cout << "  build              Build the project (default)" << std::endl;
     std::cout << "  clean              Clean build artifacts" << std::endl;
     std::cout << "  rebuild            Clean and rebuild" << std::endl;
+    std::cout << "  watch              Rebuild automatically when sources or headers change" << std::endl;
+    std::cout << "  plan               Show the jobs a build would run and predict its duration" << std::endl;
+    std::cout << "  pgo                Instrument, run the training command and rebuild with the profiles" << std::endl;
+    std::cout << "  worker             Compile sources sent by other buildpp processes (see workers)" << std::endl;
+    std::cout << "  --listen ADDR      Address of the worker: host:port or unix:/path (default: 127.0.0.1:7700)" << std::endl;
     std::cout << "  -h, --help         Show this help message" << std::endl;
     std::cout << "  -v, --verbose      Show configuration details" << std::endl;
+    std::cout << "  -j N               Run N compile jobs in parallel (default: CPU cores, fewer when memory is low)" << std::endl;
+    std::cout << "  --trace FILE       Write a build timeline (Chrome trace format) to FILE" << std::endl;
     std::cout << "\nConfig file: build.json (default)" << std::endl;
     std::cout << "\nExamples:" << std::endl;
     std::cout << "  " << programName << " init               # Initialize new project" << std::endl;
     std::cout << "  " << programName << "                    # Build using build.json" << std::endl;
     std::cout << "  " << programName << " clean              # Clean build directory" << std::endl;
     std::cout << "  " << programName << " rebuild            # Clean and rebuild" << std::endl;
+    std::cout << "  " << programName << " -j 8 build         # Build with 8 parallel jobs" << std::endl;
+    std::cout << "  " << programName << " --trace trace.json # Build and record a timeline" << std::endl;
+    std::cout << "  " << programName << " worker --listen 0.0.0.0:7700  # Run a compile worker (no authentication:" << std::endl;
+    std::cout << "                                            # anyone who can connect can use it; trusted networks only)" << std::endl;
     std::cout << "  " << programName << " myconfig.json      # Build using custom config" << std::endl;
 }
 
@@ -25,6 +40,9 @@ int main(int argc, char* argv[]) {
     std::string configFile = "build.json";
     std::string command = "build";
     bool verbose = false;
+    int jobs = 0;
+    std::string traceFile;
+    std::string listenAddress = "127.0.0.1:7700";
     
     // 解析命令行参数
     for (int i = 1; i < argc; i++) {
@@ -35,7 +53,30 @@ int main(int argc, char* argv[]) {
             return 0;
         } else if (arg == "-v" || arg == "--verbose") {
             verbose = true;
-        } else if (arg == "build" || arg == "clean" || arg == "rebuild" || arg == "init") {
+        } else if (arg == "-j" || (arg.size() > 2 && arg.compare(0, 2, "-j") == 0)) {
+            std::string value = arg.size() > 2 ? arg.substr(2) : "";
+            if (value.empty() && i + 1 < argc) {
+                value = argv[++i];
+            }
+            jobs = std::atoi(value.c_str());
+            if (jobs <= 0) {
+                std::cerr << "Invalid job count: " << value << std::endl;
+                return 1;
+            }
+        } else if (arg == "--trace") {
+            if (i + 1 >= argc) {
+                std::cerr << "Missing file name after --trace" << std::endl;
+                return 1;
+            }
+            traceFile = argv[++i];
+        } else if (arg == "--listen") {
+            if (i + 1 >= argc) {
+                std::cerr << "Missing address after --listen" << std::endl;
+                return 1;
+            }
+            listenAddress = argv[++i];
+        } else if (arg == "build" || arg == "clean" || arg == "rebuild" || arg == "init" ||
+                   arg == "watch" || arg == "plan" || arg == "pgo" || arg == "worker") {
             command = arg;
         } else if (arg.find(".json") != std::string::npos) {
             configFile = arg;
@@ -68,8 +109,25 @@ int main(int argc, char* argv[]) {
         }
     }
     
+    // 工作进程不需要配置文件，-j 为同时运行的编译任务数
+    if (command == "worker") {
+        return runWorker(listenAddress, jobs);
+    }
+    
+    // 监视模式自行加载配置，配置文件变化时重新加载
+    if (command == "watch") {
+        Watcher watcher(configFile, jobs);
+        return watcher.run();
+    }
+    
+    // 从加载配置开始记录时间线
+    BuildTrace trace;
+    if (!traceFile.empty()) {
+        trace.enable();
+    }
+    
     // 加载配置
-    ConfigParser parser;
+    ConfigParser parser(&trace);
     if (!parser.loadFromFile(configFile)) {
         std::cerr << "Failed to load configuration file: " << configFile << std::endl;
         return 1;
@@ -81,16 +139,34 @@ int main(int argc, char* argv[]) {
         std::cout << std::endl;
     }
     
-    // 创建编译器并执行命令
-    Compiler compiler(parser.getConfig());
+    // 命令行的 -j 覆盖配置文件中的 jobs
+    BuildConfig config = parser.getConfig();
+    if (jobs > 0) {
+        config.jobs = jobs;
+    }
+    
+    // 创建项目并执行命令
+    Project project(config, &trace);
     bool success = false;
     
     if (command == "build") {
-        success = compiler.build();
+        success = project.build();
     } else if (command == "clean") {
-        success = compiler.clean();
+        success = project.clean();
     } else if (command == "rebuild") {
-        success = compiler.rebuild();
+        success = project.rebuild();
+    } else if (command == "plan") {
+        success = project.plan();
+    } else if (command == "pgo") {
+        success = project.pgo();
+    }
+    
+    if (trace.enabled()) {
+        if (trace.write(traceFile)) {
+            std::cout << "\nTrace written to " << traceFile << std::endl;
+        } else {
+            std::cerr << "\nFailed to write trace file: " << traceFile << std::endl;
+        }
     }
     
     if (success) {
@@ -0,0 +1,296 @@
+#include "process.hpp"
+#include <fstream>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <spawn.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+
+std::vector<std::string> splitArgs(const std::string& text) {
+    std::vector<std::string> args;
+    std::string current;
+    bool inArg = false;
+    char quote = 0;
+    
+    for (size_t i = 0; i < text.size(); i++) {
+        char c = text[i];
+        if (quote) {
+            if (c == quote) {
+                quote = 0;
+            } else if (c == '\\' && quote == '"' && i + 1 < text.size() &&
+                       (text[i + 1] == '"' || text[i + 1] == '\\')) {
+                current += text[++i];
+            } else {
+                current += c;
+            }
+        } else if (c == '\'' || c == '"') {
+            quote = c;
+            inArg = true;
+        } else if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+            if (inArg) {
+                args.push_back(current);
+                current.clear();
+                inArg = false;
+            }
+#ifndef _WIN32
+        } else if (c == '\\' && i + 1 < text.size()) {
+            // Windows 路径中的反斜杠是分隔符，只在其他平台上作为转义
+            current += text[++i];
+            inArg = true;
+#endif
+        } else {
+            current += c;
+            inArg = true;
+        }
+    }
+    if (inArg) {
+        args.push_back(current);
+    }
+    return args;
+}
+
+// 给参数加双引号，转义其中的双引号和反斜杠
+static std::string quoteArg(const std::string& arg) {
+    std::string quoted = "\"";
+    for (char c : arg) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+        }
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+std::string joinArgs(const std::vector<std::string>& args) {
+    std::string command;
+    for (const auto& arg : args) {
+        if (!command.empty()) {
+            command += ' ';
+        }
+        if (arg.empty() || arg.find_first_of(" \t\n\"'\\$`") != std::string::npos) {
+            command += quoteArg(arg);
+        } else {
+            command += arg;
+        }
+    }
+    return command;
+}
+
+std::string findExecutable(const std::string& name) {
+    const char* path = std::getenv("PATH");
+    if (!path) {
+        return "";
+    }
+    
+#ifdef _WIN32
+    const char separator = ';';
+    std::string fileName = name + ".exe";
+#else
+    const char separator = ':';
+    std::string fileName = name;
+#endif
+    std::string dirs = path;
+    size_t start = 0;
+    while (start <= dirs.size()) {
+        size_t end = dirs.find(separator, start);
+        if (end == std::string::npos) {
+            end = dirs.size();
+        }
+        std::string dir = dirs.substr(start, end - start);
+        if (!dir.empty()) {
+            std::string candidate = dir + "/" + fileName;
+#ifdef _WIN32
+            DWORD attributes = GetFileAttributesA(candidate.c_str());
+            if (attributes != INVALID_FILE_ATTRIBUTES && !(attributes & FILE_ATTRIBUTE_DIRECTORY)) {
+                return candidate;
+            }
+#else
+            struct stat info;
+            if (stat(candidate.c_str(), &info) == 0 && S_ISREG(info.st_mode) &&
+                access(candidate.c_str(), X_OK) == 0) {
+                return candidate;
+            }
+#endif
+        }
+        start = end + 1;
+    }
+    return "";
+}
+
+// 把参数写入响应文件，返回替换后的参数列表；写入失败时返回原参数
+static std::vector<std::string> useResponseFile(const std::vector<std::string>& args,
+                                                const std::string& responseFile) {
+    std::ofstream out(responseFile, std::ios::trunc);
+    if (!out.is_open()) {
+        return args;
+    }
+    for (size_t i = 1; i < args.size(); i++) {
+        out << quoteArg(args[i]) << "\n";
+    }
+    out.close();
+    if (out.fail()) {
+        return args;
+    }
+    return {args[0], "@" + responseFile};
+}
+
+#ifdef _WIN32
+
+// Windows 命令行总长度上限为 32767 个字符
+static const size_t MAX_COMMAND_LENGTH = 32000;
+
+bool runProcess(const std::vector<std::string>& args, std::string& output,
+                const std::string& responseFile, uint64_t* peakMemoryKb) {
+    if (args.empty()) {
+        return false;
+    }
+    
+    std::string commandLine = joinArgs(args);
+    if (commandLine.size() > MAX_COMMAND_LENGTH && !responseFile.empty()) {
+        commandLine = joinArgs(useResponseFile(args, responseFile));
+    }
+    
+    SECURITY_ATTRIBUTES security = {sizeof(SECURITY_ATTRIBUTES), nullptr, TRUE};
+    HANDLE readPipe, writePipe;
+    if (!CreatePipe(&readPipe, &writePipe, &security, 0)) {
+        output += "Error: Failed to create pipe\n";
+        return false;
+    }
+    SetHandleInformation(readPipe, HANDLE_FLAG_INHERIT, 0);
+    
+    STARTUPINFOA startup = {};
+    startup.cb = sizeof(startup);
+    startup.dwFlags = STARTF_USESTDHANDLES;
+    startup.hStdInput = GetStdHandle(STD_INPUT_HANDLE);
+    startup.hStdOutput = writePipe;
+    startup.hStdError = writePipe;
+    
+    PROCESS_INFORMATION process;
+    std::vector<char> buffer(commandLine.begin(), commandLine.end());
+    buffer.push_back('\0');
+    if (!CreateProcessA(nullptr, buffer.data(), nullptr, nullptr, TRUE, 0,
+                        nullptr, nullptr, &startup, &process)) {
+        CloseHandle(readPipe);
+        CloseHandle(writePipe);
+        output += "Error: Failed to start " + args[0] + "\n";
+        return false;
+    }
+    CloseHandle(writePipe);
+    
+    char chunk[4096];
+    DWORD bytesRead;
+    while (ReadFile(readPipe, chunk, sizeof(chunk), &bytesRead, nullptr) && bytesRead > 0) {
+        output.append(chunk, bytesRead);
+    }
+    CloseHandle(readPipe);
+    
+    DWORD exitCode = 1;
+    WaitForSingleObject(process.hProcess, INFINITE);
+    GetExitCodeProcess(process.hProcess, &exitCode);
+    CloseHandle(process.hProcess);
+    CloseHandle(process.hThread);
+    if (peakMemoryKb) {
+        *peakMemoryKb = 0;
+    }
+    return exitCode == 0;
+}
+
+#else
+
+// 单个参数和整个命令行都有长度限制（Linux 上单个参数最长 128KB），超过时使用响应文件
+static const size_t MAX_COMMAND_LENGTH = 100000;
+
+bool runProcess(const std::vector<std::string>& args, std::string& output,
+                const std::string& responseFile, uint64_t* peakMemoryKb) {
+    if (args.empty()) {
+        return false;
+    }
+
+    std::vector<std::string> spawnArgs = args;
+    size_t length = 0;
+    for (const auto& arg : args) {
+        length += arg.size() + 1;
+    }
+    if (length > MAX_COMMAND_LENGTH && !responseFile.empty()) {
+        spawnArgs = useResponseFile(args, responseFile);
+    }
+
+    std::vector<char*> argv;
+    for (auto& arg : spawnArgs) {
+        argv.push_back(&arg[0]);
+    }
+    argv.push_back(nullptr);
+
+    // 管道必须带 close-on-exec，否则其他线程同时启动的子进程会继承写端，读取时等不到结束
+    int fds[2];
+#ifdef __linux__
+    if (pipe2(fds, O_CLOEXEC) != 0) {
+#else
+    if (pipe(fds) != 0 || fcntl(fds[0], F_SETFD, FD_CLOEXEC) != 0 ||
+        fcntl(fds[1], F_SETFD, FD_CLOEXEC) != 0) {
+#endif
+        output += "Error: Failed to create pipe\n";
+        return false;
+    }
+
+    // 标准输出和错误输出写入同一个管道，保持两者的先后顺序
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDERR_FILENO);
+
+    pid_t pid;
+    int error = posix_spawnp(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(fds[1]);
+    if (error != 0) {
+        close(fds[0]);
+        output += "Error: Failed to start " + args[0] + ": " + strerror(error) + "\n";
+        return false;
+    }
+
+    char chunk[4096];
+    while (true) {
+        ssize_t bytesRead = read(fds[0], chunk, sizeof(chunk));
+        if (bytesRead > 0) {
+            output.append(chunk, static_cast<size_t>(bytesRead));
+        } else if (bytesRead == 0 || errno != EINTR) {
+            break;
+        }
+    }
+    close(fds[0]);
+
+    // wait4 同时返回子进程的资源使用情况，峰值内存 ru_maxrss 在 Linux 上以 KB 为单位，macOS 上以字节为单位
+    int status = 0;
+    struct rusage usage;
+    while (wait4(pid, &status, 0, &usage) < 0) {
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+    if (peakMemoryKb) {
+#ifdef __APPLE__
+        *peakMemoryKb = static_cast<uint64_t>(usage.ru_maxrss) / 1024;
+#else
+        *peakMemoryKb = static_cast<uint64_t>(usage.ru_maxrss);
+#endif
+    }
+    if (WIFSIGNALED(status)) {
+        output += "Error: " + args[0] + " terminated by signal " + std::to_string(WTERMSIG(status)) + "\n";
+    }
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef PROCESS_HPP
+#define PROCESS_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// 按空白拆分命令行参数，支持单引号、双引号和反斜杠转义（用于配置中的编译器和编译选项）
+std::vector<std::string> splitArgs(const std::string& text);
+
+// 把参数列表转换为可显示的命令行，含空格或引号的参数加引号
+std::string joinArgs(const std::vector<std::string>& args);
+
+// 在 PATH 中查找可执行文件，返回完整路径，找不到时返回空字符串
+std::string findExecutable(const std::string& name);
+
+// 直接启动进程（不经过 shell），标准输出和错误输出都写入 output，退出码为 0 时返回 true
+// 命令行过长且指定了 responseFile 时，把除程序名外的参数写入该文件，以 @responseFile 传递
+// peakMemoryKb 不为空时写入进程的峰值内存（KB，Windows 上为 0）
+bool runProcess(const std::vector<std::string>& args, std::string& output,
+                const std::string& responseFile = "", uint64_t* peakMemoryKb = nullptr);
+
+#endif // PROCESS_HPP
@@ -0,0 +1,331 @@
+#include "project.hpp"
+#include "scheduler.hpp"
+#include "fsutil.hpp"
+#include "glob.hpp"
+#include "process.hpp"
+#include <iostream>
+#include <map>
+#include <set>
+#include <algorithm>
+#include <functional>
+#include <cstdio>
+
+Project::Project(const BuildConfig& config, BuildTrace* trace)
+    : config(config), trace(trace), cancelFlag(nullptr), valid(true) {
+    if (config.targets.empty()) {
+        compilers.emplace_back(new Compiler(config, trace));
+        return;
+    }
+    
+    valid = resolveTargets();
+    if (!valid) {
+        return;
+    }
+    for (const auto& target : targets) {
+        compilers.emplace_back(new Compiler(target, trace));
+        compilers.back()->setFileSnapshot(&snapshot);
+    }
+    
+    // 链接依赖的所有库（包括间接依赖）；依赖其他库的库排在前面，静态链接时才能解析其中的符号
+    for (size_t i = 0; i < targets.size(); i++) {
+        std::set<size_t> closure;
+        std::vector<size_t> pending = targetDeps[i];
+        while (!pending.empty()) {
+            size_t dep = pending.back();
+            pending.pop_back();
+            if (closure.insert(dep).second) {
+                pending.insert(pending.end(), targetDeps[dep].begin(), targetDeps[dep].end());
+            }
+        }
+        for (auto it = closure.rbegin(); it != closure.rend(); ++it) {
+            if (targets[*it].output_type == "library" || targets[*it].output_type == "static_library") {
+                compilers[i]->addLinkInput(compilers[*it]->getOutputFilePath());
+            }
+        }
+    }
+}
+
+bool Project::resolveTargets() {
+    std::map<std::string, size_t> index;
+    for (size_t i = 0; i < config.targets.size(); i++) {
+        index[config.targets[i].target_name] = i;
+    }
+    
+    // 深度优先排序：先放入依赖的目标，再放入目标本身
+    std::vector<int> state(config.targets.size(), 0); // 0 未访问，1 访问中，2 已完成
+    std::vector<size_t> order;
+    std::vector<size_t> sortedIndex(config.targets.size());
+    bool acyclic = true;
+    std::function<void(size_t)> visit = [&](size_t i) {
+        if (state[i] == 2 || !acyclic) {
+            return;
+        }
+        if (state[i] == 1) {
+            std::cerr << "Error: Circular dependency involving target " << config.targets[i].target_name
+                      << std::endl;
+            acyclic = false;
+            return;
+        }
+        state[i] = 1;
+        for (const auto& dep : config.targets[i].target_deps) {
+            visit(index[dep]);
+        }
+        state[i] = 2;
+        sortedIndex[i] = order.size();
+        order.push_back(i);
+    };
+    for (size_t i = 0; i < config.targets.size() && acyclic; i++) {
+        visit(i);
+    }
+    if (!acyclic) {
+        return false;
+    }
+    
+    // 每个目标的中间文件放在 build_dir/<目标名>.dir 中（避免与同名的输出文件冲突），输出文件都放在 build_dir 中
+    for (size_t i : order) {
+        BuildConfig target = config.targets[i];
+        target.build_dir = config.build_dir + "/" + target.target_name + ".dir";
+        target.output_dir = config.build_dir;
+        target.jobs = config.jobs;
+        
+        std::vector<size_t> deps;
+        for (const auto& dep : target.target_deps) {
+            deps.push_back(sortedIndex[index[dep]]);
+        }
+        targetDeps.push_back(deps);
+        targets.push_back(target);
+    }
+    
+    // 依赖的目标的包含目录（包括间接依赖）加入目标自己的包含目录；
+    // 依赖的目标已经处理过，只需合并直接依赖的结果
+    // 依赖的静态库所依赖的共享库同样链接到目标中，因此是否使用共享库也沿依赖传递
+    std::vector<bool> usesSharedLibrary(targets.size(), false);
+    for (size_t i = 0; i < targets.size(); i++) {
+        for (size_t dep : targetDeps[i]) {
+            for (const auto& dir : targets[dep].include_dirs) {
+                if (std::find(targets[i].include_dirs.begin(), targets[i].include_dirs.end(), dir) ==
+                    targets[i].include_dirs.end()) {
+                    targets[i].include_dirs.push_back(dir);
+                }
+            }
+            if (targets[dep].output_type == "library" || usesSharedLibrary[dep]) {
+                usesSharedLibrary[i] = true;
+            }
+        }
+        
+        // 共享库和依赖它的程序在同一目录中，运行时从程序所在目录查找
+        if (usesSharedLibrary[i]) {
+#ifdef __APPLE__
+            targets[i].link_flags.push_back("-Wl,-rpath,@loader_path");
+#elif !defined(_WIN32)
+            targets[i].link_flags.push_back("-Wl,-rpath,$ORIGIN");
+#endif
+        }
+    }
+    return true;
+}
+
+bool Project::build() {
+    if (!valid) {
+        return false;
+    }
+    if (config.targets.empty()) {
+        return compilers[0]->build();
+    }
+    
+    std::cout << "\n=== Starting Build ===" << std::endl;
+    std::cout << "Project: " << config.project_name << std::endl;
+    std::cout << "Targets:";
+    for (const auto& target : targets) {
+        std::cout << " " << target.target_name;
+    }
+    std::cout << "\n" << std::endl;
+    
+    JobScheduler scheduler(config.jobs, trace);
+    scheduler.setMemoryBudget(static_cast<uint64_t>(std::max(config.memory_budget_mb, 0)) * 1024);
+    scheduler.setCancelFlag(cancelFlag);
+    size_t scheduled = scheduleTargets(scheduler);
+    bool success = scheduled == targets.size() && scheduler.run();
+    for (size_t i = 0; i < scheduled; i++) {
+        compilers[i]->finishBuild();
+    }
+    
+    if (scheduler.wasCancelled()) {
+        std::cout << "\nBuild cancelled" << std::endl;
+        return false;
+    }
+    if (!success) {
+        std::cerr << "\nBuild failed" << std::endl;
+        return false;
+    }
+    
+    std::cout << "\n=== Build Successful ===" << std::endl;
+    for (const auto& compiler : compilers) {
+        std::cout << "Output: " << compiler->getOutputFilePath() << std::endl;
+    }
+    return true;
+}
+
+size_t Project::scheduleTargets(JobScheduler& scheduler) {
+    // 所有目标的任务放入同一个调度器，链接任务依赖于被依赖目标的链接任务
+    std::vector<std::vector<size_t>> linkJobs(compilers.size());
+    size_t scheduled = 0;
+    for (; scheduled < compilers.size(); scheduled++) {
+        std::vector<size_t> linkDeps;
+        if (scheduled < targetDeps.size()) {
+            for (size_t dep : targetDeps[scheduled]) {
+                linkDeps.insert(linkDeps.end(), linkJobs[dep].begin(), linkJobs[dep].end());
+            }
+        }
+        if (!compilers[scheduled]->scheduleBuild(scheduler, linkDeps, linkJobs[scheduled])) {
+            break;
+        }
+    }
+    return scheduled;
+}
+
+bool Project::plan() {
+    if (!valid) {
+        return false;
+    }
+    
+    // 检查依赖并生成与 build 相同的任务，只模拟调度，不执行
+    JobScheduler scheduler(config.jobs, trace);
+    scheduler.setMemoryBudget(static_cast<uint64_t>(std::max(config.memory_budget_mb, 0)) * 1024);
+    size_t scheduled = scheduleTargets(scheduler);
+    for (size_t i = 0; i < scheduled; i++) {
+        compilers[i]->finishBuild();
+    }
+    if (scheduled != compilers.size()) {
+        return false;
+    }
+    scheduler.printPlan();
+    return true;
+}
+
+bool Project::clean() {
+    if (config.targets.empty()) {
+        return compilers[0]->clean();
+    }
+    
+    std::cout << "Cleaning build directory..." << std::endl;
+    if (!removeAll(config.build_dir)) {
+        std::cerr << "Error: Failed to remove " << config.build_dir << std::endl;
+        return false;
+    }
+    std::cout << "Clean complete" << std::endl;
+    return true;
+}
+
+bool Project::rebuild() {
+    if (config.targets.empty()) {
+        return compilers[0]->rebuild();
+    }
+    
+    std::cout << "=== Rebuilding ===" << std::endl;
+    clean();
+    return build();
+}
+
+bool Project::pgo() {
+    if (config.pgo_train.empty()) {
+        std::cerr << "Error: pgo requires a training command: \"pgo\": { \"train\": [...] }" << std::endl;
+        return false;
+    }
+    bool clang = config.compiler.find("clang") != std::string::npos;
+    std::cout << "=== Profile-Guided Optimization ===" << std::endl;
+    
+    // 1. 插桩构建放在单独的构建目录中，与正常构建互不影响
+    std::cout << "\n[1/3] Building instrumented variant in " << config.pgo_dir << std::endl;
+    BuildConfig instrumented = config;
+    instrumented.build_dir = config.pgo_dir;
+    instrumented.pgo_instrument = true;
+    for (auto& target : instrumented.targets) {
+        target.pgo_instrument = true;
+    }
+    Project instrumentedProject(instrumented, trace);
+    instrumentedProject.setCancelFlag(cancelFlag);
+    if (!instrumentedProject.build()) {
+        return false;
+    }
+    
+    // 2. 删除上次训练的数据后运行训练命令（GCC 会把多次运行的计数累加到已有的 .gcda 中）
+    std::string rawDir = config.pgo_dir + "/raw";
+    removeAll(rawDir);
+    for (const auto& file : globFiles(config.pgo_dir + "/**/*.gcda", {})) {
+        std::remove(file.c_str());
+    }
+    std::vector<std::string> command;
+    for (std::string arg : config.pgo_train) {
+        for (size_t pos = arg.find("{build_dir}"); pos != std::string::npos;
+             pos = arg.find("{build_dir}", pos + config.pgo_dir.size())) {
+            arg.replace(pos, 11, config.pgo_dir);
+        }
+        command.push_back(arg);
+    }
+    std::cout << "\n[2/3] Training: " << joinArgs(command) << std::endl;
+    std::string output;
+    bool trained = runProcess(command, output);
+    std::cout << output;
+    if (!trained) {
+        std::cerr << "Error: Training command failed" << std::endl;
+        return false;
+    }
+    
+    // 3. clang 的原始数据合并为一个 .profdata；GCC 的 .gcda 复制到正常构建中对应的目标文件旁
+    std::cout << "\n[3/3] Merging profiles" << std::endl;
+    if (clang) {
+        std::vector<std::string> rawFiles = globFiles(rawDir + "/*.profraw", {});
+        if (rawFiles.empty()) {
+            std::cerr << "Error: The training command produced no profile data in " << rawDir << std::endl;
+            return false;
+        }
+        std::vector<std::string> merge = {"llvm-profdata", "merge", "-o", config.pgo_dir + "/default.profdata"};
+        merge.insert(merge.end(), rawFiles.begin(), rawFiles.end());
+        output.clear();
+        if (!runProcess(merge, output)) {
+            std::cerr << output << "Error: Failed to merge profiles with llvm-profdata" << std::endl;
+            return false;
+        }
+        std::cout << "Merged " << rawFiles.size() << " profiles" << std::endl;
+    } else {
+        std::vector<std::string> profiles = globFiles(config.pgo_dir + "/**/*.gcda", {});
+        if (profiles.empty()) {
+            std::cerr << "Error: The training command produced no profile data in " << config.pgo_dir << std::endl;
+            return false;
+        }
+        for (const auto& profile : profiles) {
+            std::string dest = config.build_dir + profile.substr(config.pgo_dir.size());
+            if (!createDirectories(dest.substr(0, dest.find_last_of('/'))) || !cloneFile(profile, dest, false)) {
+                std::cerr << "Error: Failed to copy " << profile << " to " << dest << std::endl;
+                return false;
+            }
+        }
+        std::cout << "Copied " << profiles.size() << " profiles" << std::endl;
+    }
+    
+    // 训练数据是编译输入，正常构建只重新编译数据发生变化的目标文件
+    return build();
+}
+
+void Project::setCancelFlag(const std::atomic<bool>* cancel) {
+    cancelFlag = cancel;
+    for (const auto& compiler : compilers) {
+        compiler->setCancelFlag(cancel);
+    }
+}
+
+void Project::invalidateFiles(const std::vector<std::string>& files) {
+    for (const auto& compiler : compilers) {
+        compiler->invalidateFiles(files);
+    }
+}
+
+std::vector<std::string> Project::getInputFiles() {
+    std::set<std::string> inputs;
+    for (const auto& compiler : compilers) {
+        std::vector<std::string> files = compiler->getInputFiles();
+        inputs.insert(files.begin(), files.end());
+    }
+    return std::vector<std::string>(inputs.begin(), inputs.end());
+}
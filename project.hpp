@@ -0,0 +1,62 @@
+#ifndef PROJECT_HPP
+#define PROJECT_HPP
+
+#include "config.hpp"
+#include "compiler.hpp"
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+
+class BuildTrace;
+
+// 项目中所有目标的构建
+// 单目标配置直接交给 Compiler；多目标配置把所有目标的编译和链接任务放入同一个调度器，
+// 互不依赖的目标并行编译，每个目标的链接在它的目标文件和依赖的目标都完成后立即开始
+class Project {
+public:
+    Project(const BuildConfig& config, BuildTrace* trace = nullptr);
+    
+    // 执行完整的构建流程
+    bool build();
+    
+    // 清理构建文件
+    bool clean();
+    
+    // 重新构建（清理后构建）
+    bool rebuild();
+    
+    // 不执行构建，按上次记录的耗时预测需要执行的任务和整个构建的耗时
+    bool plan();
+    
+    // 配置文件驱动的优化：在 build_dir/pgo 中插桩构建，运行训练命令，
+    // 合并训练数据后使用这些数据进行正常构建
+    bool pgo();
+    
+    // cancel 被设置为 true 后不再启动新的任务，build() 返回 false
+    void setCancelFlag(const std::atomic<bool>* cancel);
+    
+    // 这些文件发生了变化，下次构建时重新读取其信息
+    void invalidateFiles(const std::vector<std::string>& files);
+    
+    // 所有目标的输入文件
+    std::vector<std::string> getInputFiles();
+    
+private:
+    BuildConfig config;
+    BuildTrace* trace;
+    const std::atomic<bool>* cancelFlag;
+    std::vector<BuildConfig> targets;                 // 按依赖顺序排列，被依赖的目标在前
+    std::vector<std::vector<size_t>> targetDeps;      // 每个目标直接依赖的目标（targets 中的下标）
+    std::vector<std::unique_ptr<Compiler>> compilers;
+    FileSnapshot snapshot;                             // 所有目标共用的文件信息快照
+    bool valid;
+    
+    // 按依赖关系排序目标并生成每个目标的配置，存在循环依赖时返回 false
+    bool resolveTargets();
+    
+    // 把所有目标的任务加入调度器，返回成功加入的目标数
+    size_t scheduleTargets(JobScheduler& scheduler);
+};
+
+#endif // PROJECT_HPP
@@ -0,0 +1,557 @@
+#include "remote.hpp"
+#include "process.hpp"
+#include "scheduler.hpp"
+#include "fsutil.hpp"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+#endif
+
+// 协议（整数均为小端序）：
+//   请求: "BPW1" + uint32 参数个数 + 参数（uint32 长度 + 内容）+ uint64 长度 + 预处理后的源文件
+//   响应: "BPW1" + uint8 是否成功 + uint32 长度 + 编译器输出 + uint64 长度 + 目标文件
+// 工作进程在参数后加上 -x c++-cpp-output -c <源文件> -o <目标文件>，每个连接只处理一个请求
+static const char REMOTE_MAGIC[4] = {'B', 'P', 'W', '1'};
+static const uint64_t MAX_PAYLOAD_SIZE = 1ULL << 30;  // 客户端接收的目标文件和编译器输出
+static const uint64_t MAX_SOURCE_SIZE = 64ULL << 20;  // 工作进程接收的预处理后的源文件
+static const uint64_t MAX_ARG_SIZE = 64 * 1024;
+static const uint32_t MAX_ARG_COUNT = 4096;
+static const int CONNECT_TIMEOUT_MS = 3000;
+static const int RECEIVE_TIMEOUT_S = 600;
+
+// 工作进程收发数据的超时：不发送数据的连接不会一直占用线程
+static const int WORKER_IO_TIMEOUT_S = 60;
+
+// 工作进程同时处理的连接数上限为编译槽位数的倍数，达到上限后暂停 accept
+static const int CONNECTIONS_PER_JOB = 4;
+
+static void appendU32(std::string& buffer, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        buffer += static_cast<char>((value >> (i * 8)) & 0xff);
+    }
+}
+
+static void appendU64(std::string& buffer, uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        buffer += static_cast<char>((value >> (i * 8)) & 0xff);
+    }
+}
+
+#ifndef _WIN32
+
+struct RemoteAddress {
+    bool unixSocket;
+    std::string host;
+    std::string port;
+    std::string path;
+};
+
+static bool parseAddress(const std::string& text, RemoteAddress& address) {
+    address = RemoteAddress();
+    if (text.compare(0, 5, "unix:") == 0) {
+        address.unixSocket = true;
+        address.path = text.substr(5);
+        return !address.path.empty() && address.path.size() < sizeof(sockaddr_un().sun_path);
+    }
+    
+    std::string rest = text.compare(0, 4, "tcp:") == 0 ? text.substr(4) : text;
+    size_t colon = rest.rfind(':');
+    if (colon == std::string::npos || colon == 0 || colon + 1 == rest.size()) {
+        return false;
+    }
+    address.unixSocket = false;
+    address.host = rest.substr(0, colon);
+    address.port = rest.substr(colon + 1);
+    // IPv6 地址写在方括号中，如 [::1]:7700
+    if (address.host.size() > 2 && address.host.front() == '[' && address.host.back() == ']') {
+        address.host = address.host.substr(1, address.host.size() - 2);
+    }
+    return true;
+}
+
+static bool sendAll(int fd, const char* data, size_t size) {
+#ifdef MSG_NOSIGNAL
+    const int flags = MSG_NOSIGNAL;
+#else
+    const int flags = 0;
+#endif
+    while (size > 0) {
+        ssize_t sent = send(fd, data, size, flags);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+        data += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+static bool receiveAll(int fd, char* data, size_t size) {
+    while (size > 0) {
+        ssize_t received = recv(fd, data, size, 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return false;
+        }
+        data += received;
+        size -= static_cast<size_t>(received);
+    }
+    return true;
+}
+
+static bool receiveU32(int fd, uint32_t& value) {
+    unsigned char bytes[4];
+    if (!receiveAll(fd, reinterpret_cast<char*>(bytes), sizeof(bytes))) {
+        return false;
+    }
+    value = 0;
+    for (int i = 3; i >= 0; i--) {
+        value = (value << 8) | bytes[i];
+    }
+    return true;
+}
+
+static bool receiveU64(int fd, uint64_t& value) {
+    unsigned char bytes[8];
+    if (!receiveAll(fd, reinterpret_cast<char*>(bytes), sizeof(bytes))) {
+        return false;
+    }
+    value = 0;
+    for (int i = 7; i >= 0; i--) {
+        value = (value << 8) | bytes[i];
+    }
+    return true;
+}
+
+static bool receiveBytes(int fd, uint64_t size, std::string& value, uint64_t limit = MAX_PAYLOAD_SIZE) {
+    if (size > limit) {
+        return false;
+    }
+    value.resize(static_cast<size_t>(size));
+    return size == 0 || receiveAll(fd, &value[0], value.size());
+}
+
+static bool receiveMagic(int fd) {
+    char magic[4];
+    return receiveAll(fd, magic, sizeof(magic)) && memcmp(magic, REMOTE_MAGIC, sizeof(magic)) == 0;
+}
+
+static void configureSocket(int fd, bool tcp) {
+#ifdef SO_NOSIGPIPE
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+    if (tcp) {
+        int noDelay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    }
+}
+
+// 连接工作进程，TCP 连接最多等待 CONNECT_TIMEOUT_MS，失败时返回 -1
+static int connectTo(const RemoteAddress& address) {
+    if (address.unixSocket) {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+            return -1;
+        }
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, address.path.c_str(), sizeof(addr.sun_path) - 1);
+        if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            close(fd);
+            return -1;
+        }
+        configureSocket(fd, false);
+        return fd;
+    }
+    
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* results = nullptr;
+    if (getaddrinfo(address.host.c_str(), address.port.c_str(), &hints, &results) != 0) {
+        return -1;
+    }
+    
+    int fd = -1;
+    for (addrinfo* info = results; info && fd < 0; info = info->ai_next) {
+        fd = socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        // 非阻塞连接，不可达的主机不会让编译线程等待系统默认的超时
+        int flags = fcntl(fd, F_GETFL, 0);
+        fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+        bool connected = connect(fd, info->ai_addr, info->ai_addrlen) == 0;
+        if (!connected && errno == EINPROGRESS) {
+            pollfd pfd = {fd, POLLOUT, 0};
+            int error = 0;
+            socklen_t length = sizeof(error);
+            connected = poll(&pfd, 1, CONNECT_TIMEOUT_MS) == 1 &&
+                        getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) == 0 && error == 0;
+        }
+        if (!connected) {
+            close(fd);
+            fd = -1;
+            continue;
+        }
+        fcntl(fd, F_SETFL, flags);
+        configureSocket(fd, true);
+    }
+    freeaddrinfo(results);
+    return fd;
+}
+
+// 在地址上监听，失败时返回 -1
+static int listenOn(const RemoteAddress& address) {
+    if (address.unixSocket) {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+            return -1;
+        }
+        // 删除上次运行留下的套接字文件
+        unlink(address.path.c_str());
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, address.path.c_str(), sizeof(addr.sun_path) - 1);
+        if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(fd, 128) != 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+    
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    addrinfo* results = nullptr;
+    if (getaddrinfo(address.host.c_str(), address.port.c_str(), &hints, &results) != 0) {
+        return -1;
+    }
+    int fd = -1;
+    for (addrinfo* info = results; info && fd < 0; info = info->ai_next) {
+        fd = socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        int reuse = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        if (bind(fd, info->ai_addr, info->ai_addrlen) != 0 || listen(fd, 128) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(results);
+    return fd;
+}
+
+#endif
+
+RemoteWorkers::RemoteWorkers(const std::vector<std::string>& addresses)
+    : addresses(addresses), unavailable(addresses.size(), false), next(0) {
+}
+
+bool RemoteWorkers::compile(const std::vector<std::string>& args, const std::string& source,
+                            std::string& object, std::string& output, std::string& warnings) {
+#ifdef _WIN32
+    (void)args;
+    (void)source;
+    (void)object;
+    (void)output;
+    warnings += "Warning: Distributed compilation is not supported on Windows\n";
+    return false;
+#else
+    std::string request(REMOTE_MAGIC, sizeof(REMOTE_MAGIC));
+    appendU32(request, static_cast<uint32_t>(args.size()));
+    for (const auto& arg : args) {
+        appendU32(request, static_cast<uint32_t>(arg.size()));
+        request += arg;
+    }
+    appendU64(request, source.size());
+    request += source;
+    
+    for (size_t attempt = 0; attempt < addresses.size(); attempt++) {
+        // 从上次使用的下一个开始轮流选择，跳过不可用的工作进程
+        size_t index = addresses.size();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (size_t i = 0; i < addresses.size() && index == addresses.size(); i++) {
+                size_t candidate = (next + i) % addresses.size();
+                if (!unavailable[candidate]) {
+                    index = candidate;
+                }
+            }
+            if (index == addresses.size()) {
+                return false;
+            }
+            next = index + 1;
+        }
+    
+        RemoteAddress address;
+        int fd = parseAddress(addresses[index], address) ? connectTo(address) : -1;
+        bool transferred = false;
+        uint8_t status = 0;
+        std::string remoteOutput;
+        if (fd >= 0) {
+            timeval timeout = {RECEIVE_TIMEOUT_S, 0};
+            setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+            uint32_t outputSize = 0;
+            uint64_t objectSize = 0;
+            transferred = sendAll(fd, request.data(), request.size()) && receiveMagic(fd) &&
+                          receiveAll(fd, reinterpret_cast<char*>(&status), 1) &&
+                          receiveU32(fd, outputSize) && receiveBytes(fd, outputSize, remoteOutput) &&
+                          receiveU64(fd, objectSize) && receiveBytes(fd, objectSize, object);
+            close(fd);
+        }
+    
+        if (!transferred) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!unavailable[index]) {
+                unavailable[index] = true;
+                warnings += "Warning: Worker " + addresses[index] + " is unavailable, not using it for this build\n";
+            }
+            continue;
+        }
+    
+        output += remoteOutput;
+        return status == 1;
+    }
+    return false;
+#endif
+}
+
+#ifndef _WIN32
+
+// 编译选项中允许的类别：优化、代码生成和警告选项，以及调试信息和语言标准
+static bool isAllowedFlag(const std::string& arg) {
+    static const char* const exact[] = {"-pthread", "-pedantic", "-pedantic-errors", "-w", "-ansi"};
+    for (const char* flag : exact) {
+        if (arg == flag) {
+            return true;
+        }
+    }
+    
+    // -f 中排除加载代码、读写任意路径的文件的选项（插件、转储、PGO 数据、模块缓存、过滤列表等）
+    static const char* const deniedPrefixes[] = {
+        "-fplugin", "-fdump", "-fopt-info", "-fprofile", "-fauto-profile", "-fcs-profile",
+        "-fsave-optimization-record", "-foptimization-record", "-fmodule", "-fprebuilt-module",
+        "-fcrash-diagnostics", "-fproc-stat-report", "-ftime-trace", "-fsanitize-blacklist",
+        "-fsanitize-ignorelist", "-fxray", "-fcoverage", "-fpass-plugin", "-fembed-offload",
+        "-Wa,", "-Wl,", "-Wp,", "-mllvm"
+    };
+    for (const char* prefix : deniedPrefixes) {
+        if (arg.compare(0, strlen(prefix), prefix) == 0) {
+            return false;
+        }
+    }
+    static const char* const allowedPrefixes[] = {"-O", "-f", "-m", "-W", "-g", "-std="};
+    for (const char* prefix : allowedPrefixes) {
+        if (arg.compare(0, strlen(prefix), prefix) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 只接受 PATH 中的编译器（不带路径）和白名单中的编译选项；
+// 其他选项可能运行命令（-wrapper）、加载代码（--specs=）或写入任意路径（--output=、-MF、-save-temps=）
+static bool isAllowedCommand(const std::vector<std::string>& args, std::string& reason) {
+    if (args.empty()) {
+        reason = "empty command";
+        return false;
+    }
+    const std::string& program = args[0];
+    bool compiler = program.find("gcc") != std::string::npos || program.find("g++") != std::string::npos ||
+                    program.find("clang") != std::string::npos || program == "c++" || program == "cc";
+    if (!compiler || program.find('/') != std::string::npos) {
+        reason = "not a compiler in PATH: " + program;
+        return false;
+    }
+    for (size_t i = 1; i < args.size(); i++) {
+        if (!isAllowedFlag(args[i])) {
+            reason = "argument not allowed: " + args[i];
+            return false;
+        }
+    }
+    return true;
+}
+
+// 计数信号量：限制同时运行的编译任务数和同时处理的连接数
+class Semaphore {
+public:
+    explicit Semaphore(int count) : available(count) {}
+    
+    void acquire() {
+        std::unique_lock<std::mutex> lock(mutex);
+        wakeup.wait(lock, [this]() { return available > 0; });
+        available--;
+    }
+    
+    void release() {
+        std::lock_guard<std::mutex> lock(mutex);
+        available++;
+        wakeup.notify_one();
+    }
+    
+private:
+    int available;
+    std::mutex mutex;
+    std::condition_variable wakeup;
+};
+
+static std::mutex logMutex;
+
+// 处理一个请求：接收参数和源文件，在临时目录中编译，返回输出和目标文件
+static void handleRequest(int fd, Semaphore& slots) {
+    uint32_t argCount = 0;
+    std::vector<std::string> args;
+    bool valid = receiveMagic(fd) && receiveU32(fd, argCount) && argCount <= MAX_ARG_COUNT;
+    for (uint32_t i = 0; valid && i < argCount; i++) {
+        uint32_t length = 0;
+        std::string arg;
+        valid = receiveU32(fd, length) && receiveBytes(fd, length, arg, MAX_ARG_SIZE);
+        args.push_back(arg);
+    }
+    uint64_t sourceSize = 0;
+    std::string source;
+    valid = valid && receiveU64(fd, sourceSize) && receiveBytes(fd, sourceSize, source, MAX_SOURCE_SIZE);
+    if (!valid) {
+        return;
+    }
+    
+    std::string output;
+    std::string object;
+    std::string reason;
+    bool ok = false;
+    auto start = std::chrono::steady_clock::now();
+    if (!isAllowedCommand(args, reason)) {
+        output = "Error: Worker rejected the request: " + reason + "\n";
+    } else {
+        const char* tmp = getenv("TMPDIR");
+        std::string pattern = std::string(tmp && *tmp ? tmp : "/tmp") + "/buildpp-worker-XXXXXX";
+        std::vector<char> dir(pattern.begin(), pattern.end());
+        dir.push_back('\0');
+        
+        slots.acquire();
+        if (!mkdtemp(dir.data())) {
+            output = "Error: Worker cannot create a temporary directory\n";
+        } else {
+            std::string workDir = dir.data();
+            std::string sourceFile = workDir + "/input.ii";
+            std::string objectFile = workDir + "/output.o";
+            std::ofstream out(sourceFile, std::ios::binary);
+            out.write(source.data(), source.size());
+            out.close();
+            
+            std::vector<std::string> command = args;
+            command.insert(command.end(), {"-x", "c++-cpp-output", "-c", sourceFile, "-o", objectFile});
+            ok = out && runProcess(command, output);
+            if (ok) {
+                std::ifstream in(objectFile, std::ios::binary);
+                std::stringstream buffer;
+                buffer << in.rdbuf();
+                object = buffer.str();
+                ok = in.good() || in.eof();
+            }
+            removeAll(workDir);
+        }
+        slots.release();
+    }
+    
+    std::string response(REMOTE_MAGIC, sizeof(REMOTE_MAGIC));
+    response += static_cast<char>(ok ? 1 : 0);
+    appendU32(response, static_cast<uint32_t>(output.size()));
+    response += output;
+    appendU64(response, object.size());
+    response += object;
+    bool sent = sendAll(fd, response.data(), response.size());
+    
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    std::lock_guard<std::mutex> lock(logMutex);
+    std::cout << (ok ? "Compiled " : "Failed ") << source.size() / 1024 << " KB in " << elapsed.count() << " ms"
+              << (sent ? "" : " (client disconnected)") << std::endl;
+}
+
+#endif
+
+int runWorker(const std::string& addressText, int jobs) {
+#ifdef _WIN32
+    (void)addressText;
+    (void)jobs;
+    std::cerr << "Error: buildpp worker is not supported on Windows" << std::endl;
+    return 1;
+#else
+    RemoteAddress address;
+    if (!parseAddress(addressText, address)) {
+        std::cerr << "Error: Invalid worker address: " << addressText
+                  << " (expected host:port or unix:/path/to/socket)" << std::endl;
+        return 1;
+    }
+    
+    // 客户端断开时写入不应终止工作进程
+    signal(SIGPIPE, SIG_IGN);
+    int listenFd = listenOn(address);
+    if (listenFd < 0) {
+        std::cerr << "Error: Cannot listen on " << addressText << ": " << strerror(errno) << std::endl;
+        return 1;
+    }
+    
+    if (jobs <= 0) {
+        jobs = JobScheduler::defaultJobCount();
+    }
+    std::cout << "Worker listening on " << addressText << " (" << jobs << " jobs)" << std::endl;
+    
+    // 每个连接一个线程，接收和发送数据不占用编译槽位；连接数达到上限时等待已有连接结束再 accept
+    Semaphore slots(jobs);
+    Semaphore connections(jobs * CONNECTIONS_PER_JOB);
+    timeval timeout = {WORKER_IO_TIMEOUT_S, 0};
+    while (true) {
+        connections.acquire();
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            connections.release();
+            if (errno != EINTR) {
+                std::cerr << "Warning: accept failed: " << strerror(errno) << std::endl;
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+            continue;
+        }
+        configureSocket(fd, !address.unixSocket);
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        std::thread([fd, &slots, &connections]() {
+            handleRequest(fd, slots);
+            close(fd);
+            connections.release();
+        }).detach();
+    }
+#endif
+}
@@ -0,0 +1,34 @@
+#ifndef REMOTE_HPP
+#define REMOTE_HPP
+
+#include <string>
+#include <vector>
+#include <mutex>
+
+// 分布式编译：本机预处理源文件后，把预处理结果和编译选项发送给其他机器上的 buildpp worker，
+// 由它调用编译器并返回目标文件。地址为 "host:port"、"tcp:host:port" 或 "unix:/path/to/socket"
+
+// 连接工作进程的客户端，由所有编译线程共用
+class RemoteWorkers {
+public:
+    explicit RemoteWorkers(const std::vector<std::string>& addresses);
+    
+    // 是否配置了工作进程
+    bool enabled() const { return !addresses.empty(); }
+    
+    // 轮流选择工作进程编译预处理后的源文件，成功时 object 为目标文件的内容，output 为编译器输出；
+    // 无法连接的工作进程在本次构建中不再使用（warnings 中说明），失败时返回 false（由调用者在本机重新编译）
+    bool compile(const std::vector<std::string>& args, const std::string& source,
+                 std::string& object, std::string& output, std::string& warnings);
+    
+private:
+    std::vector<std::string> addresses;
+    std::vector<bool> unavailable;
+    size_t next;
+    std::mutex mutex;
+};
+
+// 运行工作进程：在 address 上监听，最多同时运行 jobs 个编译任务（0 表示CPU核心数），直到进程被终止
+int runWorker(const std::string& address, int jobs);
+
+#endif // REMOTE_HPP
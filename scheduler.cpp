@@ -0,0 +1,304 @@
+#include "scheduler.hpp"
+#include "trace.hpp"
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+// 计算默认并行数时每个任务预留的内存（KB）
+static const uint64_t DEFAULT_JOB_MEMORY_KB = 512 * 1024;
+
+// 系统当前的可用内存（KB），无法获取时为 0
+static uint64_t availableMemoryKb() {
+#ifdef _WIN32
+    MEMORYSTATUSEX status;
+    status.dwLength = sizeof(status);
+    if (!GlobalMemoryStatusEx(&status)) {
+        return 0;
+    }
+    return status.ullAvailPhys / 1024;
+#else
+    // Linux 的 MemAvailable 已包含可回收的页缓存，其他系统没有 /proc/meminfo，不限制
+    std::ifstream meminfo("/proc/meminfo");
+    std::string line;
+    while (std::getline(meminfo, line)) {
+        if (line.compare(0, 13, "MemAvailable:") == 0) {
+            std::istringstream value(line.substr(13));
+            uint64_t kb = 0;
+            value >> kb;
+            return kb;
+        }
+    }
+    return 0;
+#endif
+}
+
+JobScheduler::JobScheduler(int maxJobs, BuildTrace* trace)
+    : maxJobs(maxJobs > 0 ? maxJobs : defaultJobCount()), trace(trace),
+      cancelFlag(nullptr), cancelled(false), memoryBudget(0) {
+}
+
+void JobScheduler::setCancelFlag(const std::atomic<bool>* cancel) {
+    cancelFlag = cancel;
+}
+
+void JobScheduler::setMemoryBudget(uint64_t budgetKb) {
+    memoryBudget = budgetKb;
+}
+
+uint64_t JobScheduler::effectiveMemoryBudget() const {
+    return memoryBudget > 0 ? memoryBudget : availableMemoryKb();
+}
+
+int JobScheduler::defaultJobCount() {
+    unsigned int cores = std::thread::hardware_concurrency();
+    int count = cores > 0 ? static_cast<int>(cores) : 1;
+    uint64_t available = availableMemoryKb();
+    if (available > 0) {
+        uint64_t byMemory = std::max<uint64_t>(1, available / DEFAULT_JOB_MEMORY_KB);
+        count = static_cast<int>(std::min<uint64_t>(count, byMemory));
+    }
+    return count;
+}
+
+size_t JobScheduler::addJob(const Job& job) {
+    jobs.push_back(job);
+    return jobs.size() - 1;
+}
+
+bool JobScheduler::run() {
+    cancelled = false;
+    if (jobs.empty()) {
+        return true;
+    }
+    
+    // 统计每个任务尚未完成的依赖数，没有依赖的任务直接进入就绪队列
+    std::vector<size_t> pendingDeps(jobs.size(), 0);
+    std::vector<std::vector<size_t>> dependents(jobs.size());
+    for (size_t i = 0; i < jobs.size(); i++) {
+        pendingDeps[i] = jobs[i].deps.size();
+        for (size_t dep : jobs[i].deps) {
+            dependents[dep].push_back(i);
+        }
+    }
+    
+    // 就绪队列是按关键路径长度排序的堆，长度相同时先添加的任务先开始
+    std::vector<uint64_t> priority = criticalPaths(dependents);
+    auto later = [&](size_t a, size_t b) {
+        return priority[a] != priority[b] ? priority[a] < priority[b] : a > b;
+    };
+    std::vector<size_t> ready;
+    for (size_t i = 0; i < jobs.size(); i++) {
+        if (pendingDeps[i] == 0) {
+            ready.push_back(i);
+        }
+    }
+    std::make_heap(ready.begin(), ready.end(), later);
+    
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    size_t started = 0;
+    size_t finished = 0;
+    size_t running = 0;
+    uint64_t runningMemory = 0;
+    bool failed = false;
+    
+    // 优先级最高的就绪任务能否在内存预算内开始；没有任务在运行时总是开始，避免单个任务超出预算时停滞。
+    // 不跳过它启动内存较小的任务，否则内存大的任务可能一直等待
+    uint64_t budget = effectiveMemoryBudget();
+    auto canStart = [&]() {
+        return !ready.empty() &&
+               (running == 0 || budget == 0 || runningMemory + jobs[ready.front()].memory <= budget);
+    };
+    
+    // 取消只在领取任务时检查，正在运行的任务不会被中断
+    auto stopping = [&]() {
+        if (!cancelled && cancelFlag && cancelFlag->load()) {
+            cancelled = true;
+        }
+        return failed || cancelled;
+    };
+    
+    // 每个工作线程循环领取就绪任务；输出在任务结束后整体打印，避免交错
+    auto worker = [&](int slot) {
+        BuildTrace::setLane(slot);
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wakeup.wait(lock, [&]() { return stopping() || canStart() || running == 0; });
+            if (stopping() || ready.empty()) {
+                // 失败，或没有就绪任务且没有正在运行的任务可以解除阻塞
+                wakeup.notify_all();
+                return;
+            }
+            
+            std::pop_heap(ready.begin(), ready.end(), later);
+            size_t index = ready.back();
+            ready.pop_back();
+            running++;
+            runningMemory += jobs[index].memory;
+            started++;
+            std::cout << "[" << started << "/" << jobs.size() << "] "
+                      << jobs[index].description << std::endl;
+            
+            lock.unlock();
+            std::string output;
+            bool ok;
+            {
+                TraceSpan span(trace, jobs[index].description, "job");
+                ok = jobs[index].run(output);
+            }
+            lock.lock();
+            
+            running--;
+            runningMemory -= jobs[index].memory;
+            finished++;
+            if (ok) {
+                std::cout << output << std::flush;
+                for (size_t dependent : dependents[index]) {
+                    if (--pendingDeps[dependent] == 0) {
+                        ready.push_back(dependent);
+                        std::push_heap(ready.begin(), ready.end(), later);
+                    }
+                }
+            } else if (!failed) {
+                // 只显示第一个失败任务的完整输出
+                failed = true;
+                std::cerr << output << std::flush;
+            }
+            wakeup.notify_all();
+        }
+    };
+    
+    size_t threadCount = std::min(jobs.size(), static_cast<size_t>(maxJobs));
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < threadCount; i++) {
+        threads.emplace_back(worker, static_cast<int>(i) + 1);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    
+    if (failed && finished < jobs.size()) {
+        std::cerr << "Stopped after first failure (" << jobs.size() - finished
+                  << " jobs not run)" << std::endl;
+    } else if (cancelled && finished < jobs.size()) {
+        std::cout << "Cancelled (" << jobs.size() - finished << " jobs not run)" << std::endl;
+    }
+    
+    bool complete = !failed && finished == jobs.size();
+    jobs.clear();
+    return complete;
+}
+
+std::vector<uint64_t> JobScheduler::criticalPaths(const std::vector<std::vector<size_t>>& dependents) const {
+    std::vector<uint64_t> lengths(jobs.size(), 0);
+    for (size_t i = jobs.size(); i-- > 0;) {
+        uint64_t longest = 0;
+        for (size_t dependent : dependents[i]) {
+            longest = std::max(longest, lengths[dependent]);
+        }
+        lengths[i] = jobs[i].cost + longest;
+    }
+    return lengths;
+}
+
+static std::string formatDuration(uint64_t ms) {
+    char buffer[32];
+    if (ms >= 60000) {
+        snprintf(buffer, sizeof(buffer), "%llum %04.1fs", static_cast<unsigned long long>(ms / 60000),
+                 (ms % 60000) / 1000.0);
+    } else {
+        snprintf(buffer, sizeof(buffer), "%.1fs", ms / 1000.0);
+    }
+    return buffer;
+}
+
+void JobScheduler::printPlan() {
+    std::cout << "\n=== Build Plan ===" << std::endl;
+    if (jobs.empty()) {
+        std::cout << "Nothing to do" << std::endl;
+        return;
+    }
+    
+    std::vector<size_t> pendingDeps(jobs.size(), 0);
+    std::vector<std::vector<size_t>> dependents(jobs.size());
+    for (size_t i = 0; i < jobs.size(); i++) {
+        pendingDeps[i] = jobs[i].deps.size();
+        for (size_t dep : jobs[i].deps) {
+            dependents[dep].push_back(i);
+        }
+    }
+    std::vector<uint64_t> priority = criticalPaths(dependents);
+    auto later = [&](size_t a, size_t b) {
+        return priority[a] != priority[b] ? priority[a] < priority[b] : a > b;
+    };
+    std::vector<size_t> ready;
+    for (size_t i = 0; i < jobs.size(); i++) {
+        if (pendingDeps[i] == 0) {
+            ready.push_back(i);
+        }
+    }
+    std::make_heap(ready.begin(), ready.end(), later);
+    
+    // 与 run() 相同的规则模拟：有空闲槽位且内存预算足够时启动优先级最高的就绪任务，否则前进到最早结束的任务
+    std::vector<std::pair<uint64_t, size_t>> running; // (结束时间, 任务编号) 的最小堆
+    std::vector<std::pair<uint64_t, size_t>> started;  // (开始时间, 任务编号)
+    size_t slots = std::min(jobs.size(), static_cast<size_t>(maxJobs));
+    uint64_t budget = effectiveMemoryBudget();
+    uint64_t now = 0;
+    uint64_t totalCost = 0;
+    uint64_t runningMemory = 0;
+    uint64_t peakMemory = 0;
+    while (!ready.empty() || !running.empty()) {
+        while (!ready.empty() && running.size() < slots &&
+               (running.empty() || budget == 0 || runningMemory + jobs[ready.front()].memory <= budget)) {
+            std::pop_heap(ready.begin(), ready.end(), later);
+            size_t index = ready.back();
+            ready.pop_back();
+            started.push_back({now, index});
+            totalCost += jobs[index].cost;
+            runningMemory += jobs[index].memory;
+            peakMemory = std::max(peakMemory, runningMemory);
+            running.push_back({now + jobs[index].cost, index});
+            std::push_heap(running.begin(), running.end(), std::greater<std::pair<uint64_t, size_t>>());
+        }
+        std::pop_heap(running.begin(), running.end(), std::greater<std::pair<uint64_t, size_t>>());
+        now = running.back().first;
+        size_t index = running.back().second;
+        running.pop_back();
+        runningMemory -= jobs[index].memory;
+        for (size_t dependent : dependents[index]) {
+            if (--pendingDeps[dependent] == 0) {
+                ready.push_back(dependent);
+                std::push_heap(ready.begin(), ready.end(), later);
+            }
+        }
+    }
+    
+    std::cout << std::setw(10) << "Start" << std::setw(10) << "Estimate" << "  Job" << std::endl;
+    for (const auto& item : started) {
+        std::cout << std::setw(10) << formatDuration(item.first) << std::setw(10)
+                  << formatDuration(jobs[item.second].cost) << "  " << jobs[item.second].description << std::endl;
+    }
+    uint64_t criticalPath = *std::max_element(priority.begin(), priority.end());
+    std::cout << "\n" << jobs.size() << " jobs, " << slots << " parallel" << std::endl;
+    std::cout << "Total work:    " << formatDuration(totalCost) << std::endl;
+    std::cout << "Critical path: " << formatDuration(criticalPath) << std::endl;
+    std::cout << "Peak memory:   " << peakMemory / 1024 << " MB";
+    if (budget > 0) {
+        std::cout << " (budget " << budget / 1024 << " MB)";
+    }
+    std::cout << std::endl;
+    std::cout << "Predicted build time: " << formatDuration(now) << std::endl;
+    jobs.clear();
+}
@@ -0,0 +1,64 @@
+#ifndef SCHEDULER_HPP
+#define SCHEDULER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+class BuildTrace;
+
+// 一个可调度的构建任务
+struct Job {
+    std::string description;               // 任务开始时显示的提示
+    std::function<bool(std::string&)> run; // 执行任务，需要显示的输出写入参数
+    std::vector<size_t> deps;              // 必须先成功完成的任务编号
+    uint64_t cost = 0;                     // 预计耗时（毫秒）
+    uint64_t memory = 0;                   // 预计峰值内存（KB）
+};
+
+class JobScheduler {
+public:
+    // trace 不为空时每个任务槽位在时间线上占一条泳道
+    JobScheduler(int maxJobs, BuildTrace* trace = nullptr);
+    
+    // 添加任务，返回任务编号
+    size_t addJob(const Job& job);
+    
+    // 并行执行所有任务，依赖的任务完成后才开始，出现失败或被取消后不再启动新任务
+    // 就绪的任务中关键路径（任务本身及之后必须依次完成的任务的预计耗时之和）最长的先开始；
+    // 正在运行的任务与该任务的预计内存之和超过内存预算时等待，直到有任务结束
+    bool run();
+    
+    // 不执行任务，按预计耗时模拟 run() 的调度，打印每个任务的预计开始时间和整个构建的预计耗时
+    void printPlan();
+    
+    // cancel 被设置为 true 后不再启动新任务，已开始的任务正常完成
+    void setCancelFlag(const std::atomic<bool>* cancel);
+    
+    // 同时运行的任务的预计内存之和的上限（KB），0 表示使用开始运行时系统的可用内存
+    void setMemoryBudget(uint64_t budgetKb);
+    
+    // 上一次 run() 是否因取消而提前结束
+    bool wasCancelled() const { return cancelled; }
+    
+    // 默认并行数：CPU核心数，可用内存不足以让每个任务使用 512MB 时相应减少
+    static int defaultJobCount();
+    
+private:
+    int maxJobs;
+    BuildTrace* trace;
+    const std::atomic<bool>* cancelFlag;
+    bool cancelled;
+    uint64_t memoryBudget;
+    std::vector<Job> jobs;
+    
+    // 实际使用的内存预算（KB），0 表示不限制
+    uint64_t effectiveMemoryBudget() const;
+    
+    // 每个任务的关键路径长度；依赖的任务编号总是小于依赖它的任务，逆序计算一遍即可
+    std::vector<uint64_t> criticalPaths(const std::vector<std::vector<size_t>>& dependents) const;
+};
+
+#endif // SCHEDULER_HPP
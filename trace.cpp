@@ -0,0 +1,183 @@
+#include "trace.hpp"
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+
+static thread_local int currentLane = 0;
+
+BuildTrace::BuildTrace() : active(false), origin(std::chrono::steady_clock::now()), maxLane(0) {
+}
+
+void BuildTrace::enable() {
+    active = true;
+    origin = std::chrono::steady_clock::now();
+}
+
+void BuildTrace::setLane(int lane) {
+    currentLane = lane;
+}
+
+int64_t BuildTrace::now() const {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - origin).count();
+}
+
+static std::string escapeJson(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            escaped += ' ';
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+void BuildTrace::addEvent(const std::string& name, const std::string& category, int64_t start) {
+    if (!active) {
+        return;
+    }
+    int64_t end = now();
+    std::stringstream event;
+    event << "{\"name\":\"" << escapeJson(name) << "\",\"cat\":\"" << category
+          << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << currentLane
+          << ",\"ts\":" << start << ",\"dur\":" << end - start << "}";
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    events.push_back(event.str());
+    if (currentLane > maxLane) {
+        maxLane = currentLane;
+    }
+}
+
+// 替换 "key": 后面的整数；relative 为 true 时在原值上加 value
+static bool replaceNumber(std::string& object, const std::string& key, int64_t value, bool relative) {
+    size_t pos = object.find("\"" + key + "\"");
+    if (pos == std::string::npos) {
+        return false;
+    }
+    pos = object.find(':', pos);
+    if (pos == std::string::npos) {
+        return false;
+    }
+    pos = object.find_first_not_of(" \t\r\n", pos + 1);
+    if (pos == std::string::npos) {
+        return false;
+    }
+    char* end;
+    int64_t old = std::strtoll(object.c_str() + pos, &end, 10);
+    size_t length = static_cast<size_t>(end - (object.c_str() + pos));
+    if (length == 0) {
+        return false;
+    }
+    object.replace(pos, length, std::to_string(relative ? old + value : value));
+    return true;
+}
+
+void BuildTrace::mergeClangTrace(const std::string& filename, int64_t start) {
+    if (!active) {
+        return;
+    }
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        return;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string content = buffer.str();
+    
+    size_t pos = content.find("\"traceEvents\"");
+    if (pos == std::string::npos || (pos = content.find('[', pos)) == std::string::npos) {
+        return;
+    }
+    
+    // 逐个取出数组中的事件对象（跳过字符串中的括号）
+    std::vector<std::string> merged;
+    int depth = 0;
+    bool inString = false;
+    size_t objectStart = 0;
+    for (size_t i = pos + 1; i < content.size(); i++) {
+        char c = content[i];
+        if (inString) {
+            if (c == '\\') {
+                i++;
+            } else if (c == '"') {
+                inString = false;
+            }
+            continue;
+        }
+        if (c == '"') {
+            inString = true;
+        } else if (c == '{') {
+            if (depth++ == 0) {
+                objectStart = i;
+            }
+        } else if (c == '}') {
+            if (--depth != 0) {
+                continue;
+            }
+            // 只保留完整事件；"Total ..." 是按类别汇总的时间，不在时间线上
+            std::string object = content.substr(objectStart, i - objectStart + 1);
+            if (object.find("\"ph\":\"X\"") == std::string::npos ||
+                object.find("\"name\":\"Total ") != std::string::npos) {
+                continue;
+            }
+            if (!replaceNumber(object, "ts", start, true)) {
+                continue;
+            }
+            replaceNumber(object, "pid", 1, false);
+            replaceNumber(object, "tid", currentLane, false);
+            merged.push_back(object);
+        } else if (c == ']' && depth == 0) {
+            break;
+        }
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    events.insert(events.end(), merged.begin(), merged.end());
+    if (currentLane > maxLane) {
+        maxLane = currentLane;
+    }
+}
+
+bool BuildTrace::write(const std::string& filename) const {
+    std::ofstream file(filename, std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    file << "{\"traceEvents\":[\n";
+    file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"buildpp\"}}";
+    for (int lane = 0; lane <= maxLane; lane++) {
+        std::string name = lane == 0 ? "main" : "job " + std::to_string(lane);
+        file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << lane
+             << ",\"args\":{\"name\":\"" << name << "\"}}";
+    }
+    for (const auto& event : events) {
+        file << ",\n" << event;
+    }
+    file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    file.close();
+    return !file.fail();
+}
+
+TraceSpan::TraceSpan(BuildTrace* trace, const std::string& name, const std::string& category)
+    : trace(trace && trace->enabled() ? trace : nullptr), name(name), category(category),
+      start(this->trace ? this->trace->now() : 0) {
+}
+
+TraceSpan::~TraceSpan() {
+    end();
+}
+
+void TraceSpan::end() {
+    if (trace) {
+        trace->addEvent(name, category, start);
+        trace = nullptr;
+    }
+}
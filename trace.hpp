@@ -0,0 +1,59 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+
+// 构建时间线，输出为 Chrome trace 格式（可在 chrome://tracing 或 Perfetto 中查看）
+// 每个并行任务槽位一条泳道，主线程为泳道 0
+class BuildTrace {
+public:
+    BuildTrace();
+    
+    // 开始记录，未调用时所有记录操作都被忽略
+    void enable();
+    bool enabled() const { return active; }
+    
+    // 当前线程的事件写入的泳道（任务调度器为每个工作线程设置）
+    static void setLane(int lane);
+    
+    // 自开始记录以来的微秒数
+    int64_t now() const;
+    
+    // 记录一个在当前泳道上从 start 到现在的事件
+    void addEvent(const std::string& name, const std::string& category, int64_t start);
+    
+    // 合并 clang -ftime-trace 生成的文件，其中的事件从 start 开始放到当前泳道上
+    void mergeClangTrace(const std::string& filename, int64_t start);
+    
+    // 写入 JSON 文件
+    bool write(const std::string& filename) const;
+    
+private:
+    bool active;
+    std::chrono::steady_clock::time_point origin;
+    mutable std::mutex mutex;
+    std::vector<std::string> events;
+    int maxLane;
+};
+
+// 在作用域结束时记录一个事件；trace 为空或未启用时不做任何事
+class TraceSpan {
+public:
+    TraceSpan(BuildTrace* trace, const std::string& name, const std::string& category);
+    ~TraceSpan();
+    
+    // 提前结束并记录事件
+    void end();
+    
+private:
+    BuildTrace* trace;
+    std::string name;
+    std::string category;
+    int64_t start;
+};
+
+#endif // TRACE_HPP
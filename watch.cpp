@@ -0,0 +1,286 @@
+#include "watch.hpp"
+#include "config.hpp"
+#include <iostream>
+#include <chrono>
+#include <thread>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+// 最后一次变化之后等待的时间，编辑器保存时的一连串写入合并为一次构建
+static const int DEBOUNCE_MS = 100;
+
+Watcher::Watcher(const std::string& configFile, int jobs)
+    : configFile(configFile), jobs(jobs), inotifyFd(-1),
+      reloadConfig(false), eventCount(0), building(true), cancel(false) {
+}
+
+static std::string parentDirectory(const std::string& path) {
+    size_t lastSlash = path.find_last_of('/');
+    if (lastSlash == std::string::npos) {
+        return ".";
+    }
+    return lastSlash == 0 ? "/" : path.substr(0, lastSlash);
+}
+
+static std::string joinPath(const std::string& dir, const std::string& name) {
+    if (dir == ".") {
+        return name;
+    }
+    return dir.back() == '/' ? dir + name : dir + "/" + name;
+}
+
+// 以 . 开头的名称（编辑器的锁文件和备份，如 .#main.cpp）不匹配源文件模式，不会是新的源文件
+static bool isSourceName(const std::string& name) {
+    if (name.empty() || name[0] == '.') {
+        return false;
+    }
+    static const char* extensions[] = {".cpp", ".cc", ".cxx", ".c++", ".C"};
+    for (const char* ext : extensions) {
+        std::string extension = ext;
+        if (name.size() > extension.size() &&
+            name.compare(name.size() - extension.size(), extension.size(), extension) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Watcher::loadConfig() {
+    ConfigParser parser;
+    if (!parser.loadFromFile(configFile)) {
+        project.reset();
+        return false;
+    }
+    
+    BuildConfig config = parser.getConfig();
+    buildDir = config.build_dir;
+    if (jobs > 0) {
+        config.jobs = jobs;
+    }
+    project.reset(new Project(config));
+    project->setCancelFlag(&cancel);
+    return true;
+}
+
+int Watcher::run() {
+#ifndef __linux__
+    std::cerr << "Error: watch mode requires inotify and is only supported on Linux" << std::endl;
+    return 1;
+#else
+    inotifyFd = inotify_init1(IN_CLOEXEC);
+    if (inotifyFd < 0) {
+        std::cerr << "Error: Failed to initialize inotify" << std::endl;
+        return 1;
+    }
+    std::thread(&Watcher::readEvents, this).detach();
+    
+    std::vector<std::string> changedInputs;
+    bool reload = true;
+    while (true) {
+        if (reload) {
+            std::cout << "\nLoading " << configFile << std::endl;
+        }
+        bool loaded = reload ? loadConfig() : project != nullptr;
+    
+        if (loaded) {
+            project->invalidateFiles(changedInputs);
+            auto start = std::chrono::steady_clock::now();
+            project->build();
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start).count();
+            std::cout << "Finished in " << elapsed << " ms" << std::endl;
+        }
+    
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            building = false;
+        }
+        updateWatches();
+        std::cout << "\nWatching for changes... (Ctrl+C to stop)" << std::endl;
+    
+        changedInputs = waitForChanges(reload);
+        for (const auto& file : changedInputs) {
+            std::cout << "Changed: " << file << std::endl;
+        }
+    }
+#endif
+}
+
+void Watcher::updateWatches() {
+#ifdef __linux__
+    std::vector<std::string> inputs;
+    if (project) {
+        inputs = project->getInputFiles();
+    }
+    inputs.push_back(configFile);
+    
+    // 项目中的输入文件的各级上层目录也监视，** 模式可能匹配在其中新建的子目录中的文件
+    std::set<std::string> directories;
+    for (const auto& input : inputs) {
+        std::string dir = parentDirectory(input);
+        directories.insert(dir);
+        bool inProject = input[0] != '/' && input.find("..") == std::string::npos;
+        while (inProject && dir != ".") {
+            dir = parentDirectory(dir);
+            directories.insert(dir);
+        }
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    inputFiles.clear();
+    inputFiles.insert(inputs.begin(), inputs.end());
+    
+    // 同一目录的不同写法得到同一个监视描述符，事件按每种写法分别匹配
+    uint32_t mask = IN_CLOSE_WRITE | IN_ATTRIB | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO;
+    for (const auto& dir : directories) {
+        int wd = inotify_add_watch(inotifyFd, dir.c_str(), mask);
+        if (wd >= 0) {
+            watchedDirs[wd].insert(dir);
+        }
+    }
+#endif
+}
+
+bool Watcher::watchNewDirectory(const std::string& dir) {
+#ifdef __linux__
+    // 构建目录中创建的目录（obj/ 下的子目录等）不包含源文件
+    if (dir == buildDir || dir.compare(0, buildDir.size() + 1, buildDir + "/") == 0) {
+        return false;
+    }
+    uint32_t mask = IN_CLOSE_WRITE | IN_ATTRIB | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO;
+    int wd = inotify_add_watch(inotifyFd, dir.c_str(), mask);
+    if (wd < 0) {
+        return false;
+    }
+    watchedDirs[wd].insert(dir);
+    
+    // 目录可能是移动进来或用 mkdir -p 创建的，其中已经有文件和子目录
+    bool hasSources = false;
+    DIR* handle = opendir(dir.c_str());
+    if (!handle) {
+        return false;
+    }
+    while (struct dirent* entry = readdir(handle)) {
+        std::string name = entry->d_name;
+        if (name.empty() || name[0] == '.') {
+            continue;
+        }
+        std::string path = joinPath(dir, name);
+        bool isDir = entry->d_type == DT_DIR;
+        if (entry->d_type == DT_UNKNOWN) {
+            struct stat info;
+            isDir = stat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+        }
+        if (isDir) {
+            hasSources = watchNewDirectory(path) || hasSources;
+        } else if (isSourceName(name)) {
+            hasSources = true;
+        }
+    }
+    closedir(handle);
+    return hasSources;
+#else
+    (void)dir;
+    return false;
+#endif
+}
+
+std::vector<std::string> Watcher::waitForChanges(bool& reload) {
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [this]() { return !changedFiles.empty() || reloadConfig; });
+    
+    // 等到连续 DEBOUNCE_MS 没有新的变化
+    while (true) {
+        size_t lastCount = eventCount;
+        changed.wait_for(lock, std::chrono::milliseconds(DEBOUNCE_MS));
+        if (eventCount == lastCount) {
+            break;
+        }
+    }
+    
+    std::vector<std::string> files(changedFiles.begin(), changedFiles.end());
+    changedFiles.clear();
+    reload = reloadConfig;
+    reloadConfig = false;
+    building = true;
+    cancel = false;
+    return files;
+}
+
+void Watcher::readEvents() {
+#ifdef __linux__
+    alignas(struct inotify_event) char buffer[64 * 1024];
+    while (true) {
+        ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            if (length < 0 && errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        
+        std::lock_guard<std::mutex> lock(mutex);
+        bool relevant = false;
+        for (char* pos = buffer; pos < buffer + length;) {
+            struct inotify_event* event = reinterpret_cast<struct inotify_event*>(pos);
+            pos += sizeof(struct inotify_event) + event->len;
+            if (event->len == 0) {
+                continue;
+            }
+            
+            std::string name = event->name;
+            auto dirs = watchedDirs.find(event->wd);
+            if (dirs == watchedDirs.end()) {
+                continue;
+            }
+            bool added = event->mask & (IN_CREATE | IN_MOVED_TO);
+            bool addedOrRemoved = added || (event->mask & (IN_DELETE | IN_MOVED_FROM));
+            bool isDir = event->mask & IN_ISDIR;
+            std::set<std::string> spellings = dirs->second;
+            for (const auto& dir : spellings) {
+                std::string path = joinPath(dir, name);
+                if (path == configFile) {
+                    // 配置变化时重新读取配置并重新扫描源文件目录
+                    reloadConfig = true;
+                    relevant = true;
+                } else if (inputFiles.count(path)) {
+                    changedFiles.insert(path);
+                    relevant = true;
+                } else if (isDir && name[0] != '.') {
+                    // 新建的子目录立即监视，之后在其中创建的源文件也能发现；
+                    // 移入了已有源文件的目录，或移走、删除了包含输入文件的目录时重新扫描
+                    bool rescan = false;
+                    if (added) {
+                        rescan = watchNewDirectory(path);
+                    } else if (addedOrRemoved) {
+                        auto it = inputFiles.lower_bound(path + "/");
+                        rescan = it != inputFiles.end() && it->compare(0, path.size() + 1, path + "/") == 0;
+                    }
+                    if (rescan) {
+                        reloadConfig = true;
+                        relevant = true;
+                    }
+                } else if (addedOrRemoved && isSourceName(name)) {
+                    // 源文件目录中新增了文件，重新扫描
+                    reloadConfig = true;
+                    relevant = true;
+                }
+            }
+        }
+        
+        if (relevant) {
+            eventCount++;
+            if (building) {
+                cancel = true;
+            }
+            changed.notify_all();
+        }
+    }
+#endif
+}
@@ -0,0 +1,59 @@
+#ifndef WATCH_HPP
+#define WATCH_HPP
+
+#include "project.hpp"
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+
+// 常驻监视模式：配置、文件信息缓存和依赖关系保留在内存中，
+// 通过 inotify 监视源文件、头文件和配置文件，变化后只重新编译受影响的源文件
+class Watcher {
+public:
+    // jobs 大于 0 时覆盖配置文件中的 jobs
+    Watcher(const std::string& configFile, int jobs);
+    
+    // 构建并持续监视，直到进程被中断；不支持的平台上返回非 0
+    int run();
+    
+private:
+    std::string configFile;
+    std::string buildDir;
+    int jobs;
+    std::unique_ptr<Project> project;
+    int inotifyFd;
+    
+    // 以下成员由读取事件的线程和构建线程共享，受 mutex 保护
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::map<int, std::set<std::string>> watchedDirs;  // inotify 监视描述符 -> 目录
+    std::set<std::string> inputFiles;
+    std::set<std::string> changedFiles;
+    bool reloadConfig;
+    size_t eventCount;
+    bool building;
+    std::atomic<bool> cancel;
+    
+    // 读取配置文件并创建项目，失败时返回 false
+    bool loadConfig();
+    
+    // 监视所有输入文件所在的目录（保存文件时编辑器常常以新文件替换原文件）
+    void updateWatches();
+    
+    // 等待文件变化，连续一段时间没有新的变化后返回变化的文件
+    std::vector<std::string> waitForChanges(bool& reload);
+    
+    // 监视新建的目录及其中已有的子目录（源文件模式中的 ** 可能匹配其中的文件），
+    // 其中已有源文件时返回 true；调用时持有 mutex
+    bool watchNewDirectory(const std::string& dir);
+    
+    // 后台线程：读取 inotify 事件，记录相关的变化，构建进行中时请求取消
+    void readEvents();
+};
+
+#endif // WATCH_HPP